@@ -11,11 +11,13 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 
+#include "autotuner.hpp"
 #include "ising_2d.hpp"
 
 int main(int argc, char* argv[]) {
@@ -27,8 +29,17 @@ int main(int argc, char* argv[]) {
     std::string out_dir              = ".";
     double      x_anisotropic_factor = 1.0;
     double      y_anisotropic_factor = 1.0;
+    std::string frame_format_name    = "csv";
+    std::size_t export_stride        = 1;
+    std::size_t target_width         = 0;
+    std::string long_range           = "";
+    std::size_t domain_stride        = 0;
 
-    std::cout << "Usage: " << argv[0] << " [size_x] [size_y] [nb_steps] [temperature] [filename] [outdir]" << std::endl;
+    std::cout << "Usage: " << argv[0]
+              << " [size_x] [size_y] [nb_steps] [temperature] [filename] [outdir] [x_anisotropic_factor] [y_anisotropic_factor] "
+                 "[frame_format (csv|ppm|png|gif|trajectory)] [export_stride] [target_width] "
+                 "[long_range (none|power_law:coupling[:exponent]|dipolar:coupling)] [domain_stride]"
+              << std::endl;
     if (argc > 1) {
         size_x = std::stoi(argv[1]);
     }
@@ -53,6 +64,21 @@ int main(int argc, char* argv[]) {
     if (argc > 8) {
         y_anisotropic_factor = std::stod(argv[8]);
     }
+    if (argc > 9) {
+        frame_format_name = argv[9];
+    }
+    if (argc > 10) {
+        export_stride = std::stoi(argv[10]);
+    }
+    if (argc > 11) {
+        target_width = std::stoi(argv[11]);
+    }
+    if (argc > 12) {
+        long_range = argv[12];
+    }
+    if (argc > 13) {
+        domain_stride = std::stoi(argv[13]);
+    }
     if (argc <= 6) {
         out_dir = "ising2d_results_" + std::to_string(size_x) + "x" + std::to_string(size_y) + "_T" + std::to_string(temperature) + "/";
     }
@@ -62,12 +88,29 @@ int main(int argc, char* argv[]) {
     ising_2d my_ising_2d(size_x, size_y, temperature);
     my_ising_2d.set_x_anisotropic_factor(x_anisotropic_factor);
     my_ising_2d.set_y_anisotropic_factor(y_anisotropic_factor);
+    frame_export_options frame_options;
+    frame_options.format       = parse_frame_format(frame_format_name);
+    frame_options.stride       = export_stride;
+    frame_options.target_width = target_width;
+    my_ising_2d.set_frame_export(frame_options);
+    if (!long_range.empty() && long_range != "none") {
+        my_ising_2d.set_long_range_interaction(parse_long_range(long_range));
+    }
+    my_ising_2d.set_domain_measurement(domain_stride, out_dir + "/" + filename);
     my_ising_2d.initialize_random(0.45);
+    if (std::getenv("ISING_AUTOTUNE") != nullptr) {
+        kernel_autotuner    tuner;
+        const tuning_result tuning = tuner.tune(my_ising_2d);
+        std::cout << "Metropolis kernel: " << to_string(tuning.configuration) << (tuning.from_cache ? " (from " : " (tuned, cached in ")
+                  << tuner.get_cache_file() << ")" << std::endl;
+    }
     my_ising_2d.metropolis_simulation_with_export(nb_steps, out_dir + "/" + filename);
 
-    const std::string python_script = CMAKE_SOURCE_DIR + std::string("/python/parse_Ising2d.py");
-    const std::string python_call = "python3 " + python_script + " -d " + out_dir + " -s 0";
-    int python_success = system(python_call.c_str());
+    if (frame_options.format == frame_format::csv) {
+        const std::string python_script = CMAKE_SOURCE_DIR + std::string("/python/parse_Ising2d.py");
+        const std::string python_call = "python3 " + python_script + " -d " + out_dir + " -s 0";
+        int python_success = system(python_call.c_str());
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -10,11 +10,13 @@
  */
 #include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 
+#include "autotuner.hpp"
 #include "ising_2d.hpp"
 #include "ising_3d.hpp"
 
@@ -29,8 +31,18 @@ int main(int argc, char* argv[]) {
     double      x_anisotropic_factor = 1.0;
     double      y_anisotropic_factor = 1.0;
     double      z_anisotropic_factor = 1.0;
+    std::string frame_format_name    = "csv";
+    std::size_t export_stride        = 1;
+    std::size_t target_width         = 0;
+    std::string frame_mode           = "slice";
+    std::string long_range           = "";
+    std::size_t domain_stride        = 0;
 
-    std::cout << "Usage: " << argv[0] << " [size_x] [size_y] [size_z] [nb_steps] [temperature] [filename] [outdir]" << std::endl;
+    std::cout << "Usage: " << argv[0]
+              << " [size_x] [size_y] [size_z] [nb_steps] [temperature] [filename] [outdir] [x_anisotropic_factor] [y_anisotropic_factor] "
+                 "[z_anisotropic_factor] [frame_format (csv|ppm|png|gif|trajectory)] [export_stride] [target_width] [frame_mode (slice|projection)] "
+                 "[long_range (none|power_law:coupling[:exponent]|dipolar:coupling)] [domain_stride]"
+              << std::endl;
     if (argc > 1) {
         size_x = std::stoi(argv[1]);
     }
@@ -61,13 +73,56 @@ int main(int argc, char* argv[]) {
     if (argc > 10) {
         z_anisotropic_factor = std::stod(argv[10]);
     }
+    if (argc > 11) {
+        frame_format_name = argv[11];
+    }
+    if (argc > 12) {
+        export_stride = std::stoi(argv[12]);
+    }
+    if (argc > 13) {
+        target_width = std::stoi(argv[13]);
+    }
+    if (argc > 14) {
+        frame_mode = argv[14];
+    }
+    if (argc > 15) {
+        long_range = argv[15];
+    }
+    if (argc > 16) {
+        domain_stride = std::stoi(argv[16]);
+    }
 
     std::filesystem::create_directories(out_dir);
-    ising_3d my_ising_3d(size_x, size_y, size_y, temperature);
+    // ISING_SPIN_DIR keeps the spins in a memory-mapped file of that directory, for lattices larger than the RAM.
+    const char* spin_directory = std::getenv("ISING_SPIN_DIR");
+    ising_3d    my_ising_3d(size_x, size_y, size_z, temperature, spin_directory != nullptr ? spin_directory : "");
+    if (my_ising_3d.is_file_backed()) {
+        std::cout << "Spins stored in " << spin_directory << " (" << my_ising_3d.get_number_spins() * sizeof(double) / (1 << 20)
+                  << " MiB), sequential sweep" << std::endl;
+    }
     my_ising_3d.set_x_anisotropic_factor(x_anisotropic_factor);
     my_ising_3d.set_y_anisotropic_factor(y_anisotropic_factor);
     my_ising_3d.set_z_anisotropic_factor(z_anisotropic_factor);
+    frame_export_options frame_options;
+    frame_options.format       = parse_frame_format(frame_format_name);
+    frame_options.stride       = export_stride;
+    frame_options.target_width = target_width;
+    frame_options.mode_3d      = frame_mode == "projection" ? frame_mode_3d::projection : frame_mode_3d::slice;
+    frame_options.slice_index  = size_z / 2;
+    my_ising_3d.set_frame_export(frame_options);
+    if (!long_range.empty() && long_range != "none") {
+        my_ising_3d.set_long_range_interaction(parse_long_range(long_range));
+    }
+    my_ising_3d.set_domain_measurement(domain_stride, out_dir + "/" + filename);
     my_ising_3d.initialize_random(0.45);
+    if (std::getenv("ISING_AUTOTUNE") != nullptr && my_ising_3d.is_file_backed()) {
+        std::cout << "Metropolis kernel: autotuning skipped, the spins are file-backed (ISING_SPIN_DIR)" << std::endl;
+    } else if (std::getenv("ISING_AUTOTUNE") != nullptr) {
+        kernel_autotuner    tuner;
+        const tuning_result tuning = tuner.tune(my_ising_3d);
+        std::cout << "Metropolis kernel: " << to_string(tuning.configuration) << (tuning.from_cache ? " (from " : " (tuned, cached in ")
+                  << tuner.get_cache_file() << ")" << std::endl;
+    }
     my_ising_3d.metropolis_simulation_with_export(nb_steps, out_dir + "/" + filename);
 
     return 0;
@@ -11,10 +11,13 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 
+#include "autotuner.hpp"
 #include "ising_2d.hpp"
 #include "ising_3d.hpp"
 
@@ -24,7 +27,9 @@ void ising_3d_span_temperature(std::size_t        size_x,
                                double             temperature_min,
                                double             temperature_max,
                                double             temperature_step,
-                               const std::string& filename) {
+                               const std::string& filename,
+                               std::size_t        correlation_stride,
+                               sweep_order        order) {
     std::ofstream file(filename);
     file << std::setprecision(10);
     std::size_t         nb_temperatures = (temperature_max - temperature_min) / temperature_step + 1;
@@ -37,12 +42,22 @@ void ising_3d_span_temperature(std::size_t        size_x,
         temperatures[i] = temperature_min + i * temperature_step;
     }
     std::cout << "nb temperatures: " << nb_temperatures << std::endl;
+    if (std::getenv("ISING_PIN_THREADS") != nullptr && !spin_memory::pin_openmp_threads()) {
+        std::cerr << "Warning: unable to pin the OpenMP threads." << std::endl;
+    }
     const double threshold         = 1e-8;
     std::size_t  temperature_count = 0;
 #pragma omp parallel for schedule(dynamic) reduction(+ : temperature_count)
     for (std::size_t i = 0; i < nb_temperatures; ++i) {
         ising_3d ising(size_x, size_y, size_z, temperatures[i]);
+        ising.set_sweep_order(order);
         ising.initialize_random(0.1);
+        if (correlation_stride > 0) {
+            std::ostringstream correlation_filename;
+            correlation_filename << filename.substr(0, filename.find_last_of('.')) << "_T" << std::fixed << std::setprecision(3)
+                                 << temperatures[i];
+            ising.set_correlation_measurement(correlation_stride, correlation_filename.str());
+        }
         const int    nb_iter          = 20'000;
         ising_result result           = ising.metropolis_simulation(nb_iter, threshold);
         energies[i]                   = result.energy;
@@ -69,8 +84,12 @@ int main(int argc, char* argv[]) {
     double      min_temperature  = 0.1;
     double      max_temperature  = 1.0;
     double      temperature_step = 0.1;
-    std::string filename         = "ising_2d.csv";
-    std::cout << "Usage: " << argv[0] << " [size_x] [size_y] [size_z] [min_temperature] [max_temperature] [temperature_step] [filename]"
+    std::string filename           = "ising_2d.csv";
+    std::size_t correlation_stride = 0;
+    sweep_order order              = sweep_order::random;
+    std::cout << "Usage: " << argv[0]
+              << " [size_x] [size_y] [size_z] [min_temperature] [max_temperature] [temperature_step] [filename] [correlation_stride] "
+                 "[sweep_order (random|sequential|strided|auto)]"
               << std::endl;
     if (argc > 1) {
         size_x = std::stoi(argv[1]);
@@ -95,6 +114,21 @@ int main(int argc, char* argv[]) {
     } else {
         filename = "ising_3d_" + std::to_string(size_x) + "x" + std::to_string(size_y) + "z" + std::to_string(size_z) + ".csv";
     }
-    ising_3d_span_temperature(size_x, size_y, size_z, min_temperature, max_temperature, temperature_step, filename);
+    if (argc > 8) {
+        correlation_stride = std::stoi(argv[8]);
+    }
+    if (argc > 9 && std::string(argv[9]) == "auto") {
+        // The temperatures already run in parallel: only the serial kernels are candidates.
+        ising_3d representative(size_x, size_y, size_z, 0.5 * (min_temperature + max_temperature));
+        representative.initialize_random(0.1);
+        autotune_options options;
+        options.max_threads = 1;
+        kernel_autotuner tuner(options);
+        order = tuner.tune(representative).configuration.order;
+        std::cout << "Sweep order selected by the autotuner: " << to_string(kernel_configuration{order, 1}) << std::endl;
+    } else if (argc > 9) {
+        order = parse_sweep_order(argv[9]);
+    }
+    ising_3d_span_temperature(size_x, size_y, size_z, min_temperature, max_temperature, temperature_step, filename, correlation_stride, order);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+/**
+ * @file ising_wang_landau.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief
+ * @version 0.1
+ * @date 2022-09-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "wang_landau.hpp"
+
+int main(int argc, char* argv[]) {
+    int         dimension        = 2;
+    std::size_t size_x           = 16;
+    std::size_t size_y           = 16;
+    std::size_t size_z           = 16;
+    std::size_t nb_windows       = 4;
+    double      min_temperature  = 0.1;
+    double      max_temperature  = 5.0;
+    double      temperature_step = 0.05;
+    std::string filename         = "ising_wang_landau";
+    std::string checkpoint_file  = "";
+
+    std::cout << "Usage: " << argv[0]
+              << " [dimension] [size_x] [size_y] [size_z] [nb_windows] [min_temperature] [max_temperature] [temperature_step] "
+                 "[filename] [checkpoint_file]"
+              << std::endl;
+    if (argc > 1) {
+        dimension = std::stoi(argv[1]);
+    }
+    if (argc > 2) {
+        size_x = std::stoi(argv[2]);
+    }
+    if (argc > 3) {
+        size_y = std::stoi(argv[3]);
+    }
+    if (argc > 4) {
+        size_z = std::stoi(argv[4]);
+    }
+    if (argc > 5) {
+        nb_windows = std::stoi(argv[5]);
+    }
+    if (argc > 6) {
+        min_temperature = std::stod(argv[6]);
+    }
+    if (argc > 7) {
+        max_temperature = std::stod(argv[7]);
+    }
+    if (argc > 8) {
+        temperature_step = std::stod(argv[8]);
+    }
+    if (argc > 9) {
+        filename = argv[9];
+    }
+    if (argc > 10) {
+        checkpoint_file = argv[10];
+    }
+
+    std::unique_ptr<ising_base> lattice;
+    if (dimension == 3) {
+        lattice = std::make_unique<ising_3d>(size_x, size_y, size_z);
+    } else {
+        lattice = std::make_unique<ising_2d>(size_x, size_y);
+    }
+
+    wang_landau_parameters parameters;
+    parameters.nb_windows      = nb_windows;
+    parameters.checkpoint_file = checkpoint_file;
+    wang_landau sampler(*lattice, parameters);
+    if (!checkpoint_file.empty() && std::filesystem::exists(checkpoint_file)) {
+        std::cout << "Resuming from checkpoint " << checkpoint_file << std::endl;
+        sampler.load_checkpoint(checkpoint_file);
+    }
+    sampler.run();
+    std::cout << "Density of states converged in " << sampler.get_number_rounds() << " rounds." << std::endl;
+    sampler.export_density_of_states(filename + "_dos.csv");
+
+    std::ofstream file(filename + ".csv");
+    file << std::setprecision(10);
+    file << "temperature, energy, magnetization, specific_heat, susceptibility" << std::endl;
+    std::size_t nb_temperatures = (max_temperature - min_temperature) / temperature_step + 1;
+    for (std::size_t i = 0; i < nb_temperatures; ++i) {
+        const double temperature = min_temperature + i * temperature_step;
+        ising_result result      = sampler.compute_thermodynamics(temperature);
+        file << temperature << "," << result.energy << "," << result.magnetization << "," << result.specific_heat << ","
+             << result.susceptibility << std::endl;
+    }
+    return 0;
+}
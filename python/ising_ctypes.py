@@ -0,0 +1,164 @@
+"""Python bindings of the Ising shared library (libising.so) through ctypes.
+
+The spin configuration is exposed as a numpy array that views the live C++
+buffer: no copy and no file round-trip are needed to plot or animate the
+lattice while it is being simulated.
+
+Example:
+    python3 ising_ctypes.py -x 400 -y 200 -t 1.5
+"""
+
+import ctypes
+import os
+from argparse import ArgumentParser
+
+import numpy as np
+
+ISING_ABI_VERSION = 1
+
+
+class IsingObservables(ctypes.Structure):
+    _fields_ = [("energy", ctypes.c_double),
+                ("magnetization", ctypes.c_double),
+                ("specific_heat", ctypes.c_double),
+                ("susceptibility", ctypes.c_double)]
+
+
+def find_library():
+    """Locate libising.so: $ISING_LIBRARY first, then the usual build directories."""
+    if "ISING_LIBRARY" in os.environ:
+        return os.environ["ISING_LIBRARY"]
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    for build_dir in ["build", "_build", "cmake-build-release", "cmake-build-debug"]:
+        candidate = os.path.join(root, build_dir, "src", "libising.so")
+        if os.path.exists(candidate):
+            return candidate
+    return "libising.so"
+
+
+def load_library(path=None):
+    lib = ctypes.CDLL(path or find_library())
+    handle = ctypes.c_void_p
+    size_t = ctypes.c_size_t
+
+    lib.ising_abi_version.restype = ctypes.c_int
+    lib.ising_last_error.restype = ctypes.c_char_p
+    lib.ising_create_2d.argtypes = [size_t, size_t, ctypes.c_double]
+    lib.ising_create_2d.restype = handle
+    lib.ising_create_3d.argtypes = [size_t, size_t, size_t, ctypes.c_double]
+    lib.ising_create_3d.restype = handle
+    lib.ising_destroy.argtypes = [handle]
+    lib.ising_destroy.restype = None
+    lib.ising_set_seed.argtypes = [handle, ctypes.c_uint]
+    lib.ising_set_temperature.argtypes = [handle, ctypes.c_double]
+    lib.ising_set_anisotropic_factors.argtypes = [handle, ctypes.c_double, ctypes.c_double, ctypes.c_double]
+    lib.ising_initialize_random.argtypes = [handle, ctypes.c_double]
+    lib.ising_reset_spins.argtypes = [handle]
+    lib.ising_metropolis_sweeps.argtypes = [handle, size_t]
+    lib.ising_get_observables.argtypes = [handle, ctypes.POINTER(IsingObservables)]
+    lib.ising_spin_buffer.argtypes = [handle]
+    lib.ising_spin_buffer.restype = ctypes.POINTER(ctypes.c_double)
+    lib.ising_spin_shape.argtypes = [handle, ctypes.POINTER(size_t), ctypes.POINTER(size_t)]
+
+    if lib.ising_abi_version() != ISING_ABI_VERSION:
+        raise RuntimeError(f"Unsupported libising ABI version {lib.ising_abi_version()}")
+    return lib
+
+
+class IsingLattice:
+    """2D (size_z is None) or 3D Ising lattice living in the C++ library."""
+
+    def __init__(self, size_x, size_y, size_z=None, temperature=1.0, lib=None):
+        self.lib = lib or load_library()
+        if size_z is None:
+            self.handle = self.lib.ising_create_2d(size_x, size_y, temperature)
+        else:
+            self.handle = self.lib.ising_create_3d(size_x, size_y, size_z, temperature)
+        if not self.handle:
+            raise RuntimeError(self.lib.ising_last_error().decode())
+
+    def __del__(self):
+        if getattr(self, "handle", None):
+            self.lib.ising_destroy(self.handle)
+            self.handle = None
+
+    def _check(self, status):
+        if status != 0:
+            raise RuntimeError(self.lib.ising_last_error().decode())
+
+    def set_seed(self, seed):
+        self._check(self.lib.ising_set_seed(self.handle, seed))
+
+    def set_temperature(self, temperature):
+        self._check(self.lib.ising_set_temperature(self.handle, temperature))
+
+    def set_anisotropic_factors(self, x_factor=1.0, y_factor=1.0, z_factor=1.0):
+        self._check(self.lib.ising_set_anisotropic_factors(self.handle, x_factor, y_factor, z_factor))
+
+    def initialize_random(self, probability):
+        self._check(self.lib.ising_initialize_random(self.handle, probability))
+
+    def reset_spins(self):
+        self._check(self.lib.ising_reset_spins(self.handle))
+
+    def sweeps(self, nb_sweeps=1):
+        self._check(self.lib.ising_metropolis_sweeps(self.handle, nb_sweeps))
+
+    def observables(self):
+        result = IsingObservables()
+        self._check(self.lib.ising_get_observables(self.handle, ctypes.byref(result)))
+        return {name: getattr(result, name) for name, _ in IsingObservables._fields_}
+
+    @property
+    def shape(self):
+        shape = (ctypes.c_size_t * 3)()
+        ndim = ctypes.c_size_t()
+        self._check(self.lib.ising_spin_shape(self.handle, shape, ctypes.byref(ndim)))
+        return tuple(shape[:ndim.value])
+
+    @property
+    def spins(self):
+        """Zero-copy numpy view of the spins, shape (size_y, size_x) or (size_z, size_y, size_x).
+
+        The view holds a reference to the lattice, which is only destroyed once every view is gone.
+        """
+        shape = self.shape
+        pointer = self.lib.ising_spin_buffer(self.handle)
+        buffer = (ctypes.c_double * int(np.prod(shape))).from_address(ctypes.addressof(pointer.contents))
+        # The view keeps the buffer (its .base), which keeps the lattice alive: the spins are not freed under it.
+        buffer._owner = self
+        return np.frombuffer(buffer, dtype=np.float64).reshape(shape)
+
+
+def animate(lattice, sweeps_per_frame, nb_frames):
+    import matplotlib.pyplot as plt
+    import matplotlib.animation as animation
+
+    spins = lattice.spins
+    fig, axs = plt.subplots(1, figsize=(10, 10 * spins.shape[0] / spins.shape[1]), facecolor='k')
+    axs.set_axis_off()
+    im = axs.imshow(spins, interpolation='nearest', cmap='plasma', vmin=-1.0, vmax=1.0)
+    fig.tight_layout()
+
+    def update(i):
+        lattice.sweeps(sweeps_per_frame)
+        im.set_data(spins)
+        return [im]
+
+    ani = animation.FuncAnimation(fig, update, frames=nb_frames, blit=True, interval=1.0 / 30, repeat=False)
+    plt.show()
+    return ani
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser()
+    parser.add_argument("-x", "--size_x", type=int, default=200, dest="size_x")
+    parser.add_argument("-y", "--size_y", type=int, default=200, dest="size_y")
+    parser.add_argument("-t", "--temperature", type=float, default=1.5, dest="temperature")
+    parser.add_argument("-s", "--sweeps", help="Sweeps per frame", type=int, default=1, dest="sweeps")
+    parser.add_argument("-N", "--frames", help="Number of frames", type=int, default=1000, dest="frames")
+    args = parser.parse_args()
+
+    LATTICE = IsingLattice(args.size_x, args.size_y, temperature=args.temperature)
+    LATTICE.initialize_random(0.5)
+    animate(LATTICE, args.sweeps, args.frames)
@@ -6,8 +6,8 @@ import matplotlib.animation as animation
 
 def get_configuration(filename):
     X, Y, Spins = np.loadtxt(filename, unpack=True, delimiter=",", skiprows=1)
-    nx = int(np.sqrt(len(X)))
-    ny = int(np.sqrt(len(Y)))
+    nx = len(np.unique(X))
+    ny = len(np.unique(Y))
 
     Spins = Spins.reshape((nx, ny))
 
@@ -0,0 +1,149 @@
+"""Reader of the trajectory files written by the Ising simulations (frame format "trajectory").
+
+A trajectory stores a keyframe (the bit-packed spins) every K sweeps and, for the
+other sweeps, the sorted indices of the spins that changed, as varint-encoded
+gaps. Any sweep is rebuilt exactly from the last keyframe before it. The file is
+memory-mapped, so only the headers of the records and the payloads being replayed
+are read, and the payloads are decoded with vectorized numpy operations.
+
+Example:
+    python3 trajectory_reader.py results/ising_2d_map.trajectory --sweep 120 --output sweep_120.npy
+"""
+
+from argparse import ArgumentParser
+
+import numpy as np
+
+MAGIC = b"ISTRAJ1\n"
+
+
+def read_varint(data, position):
+    """Decode an unsigned LEB128 varint, return (value, next position)."""
+    value = 0
+    shift = 0
+    while True:
+        if position >= len(data):
+            raise EOFError("truncated varint")
+        byte = int(data[position])
+        position += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, position
+        shift += 7
+
+
+def decode_varints(data):
+    """Decode a buffer made of consecutive unsigned LEB128 varints, return them as a uint64 array."""
+    data = np.asarray(data, dtype=np.uint8)
+    ends = np.flatnonzero(data < 0x80)
+    if len(data) == 0 or len(ends) == 0 or ends[-1] != len(data) - 1:
+        raise EOFError("truncated varint")
+    starts = np.concatenate(([0], ends[:-1] + 1))
+    # Byte k of a varint holds the bits 7 k to 7 k + 6 of its value.
+    shifts = (np.arange(len(data)) - np.repeat(starts, ends - starts + 1)) * 7
+    groups = (data & 0x7F).astype(np.uint64) << shifts.astype(np.uint64)
+    return np.add.reduceat(groups, starts)
+
+
+class TrajectoryReader:
+    """Random access to the configurations of a trajectory file.
+
+    configuration(sweep) returns the spins (+1 / -1) after the given sweep, with the
+    shape (size_z, size_y, size_x) in 3D and (size_y, size_x) in 2D. Iterating over
+    the reader yields the configurations of all the sweeps in order.
+    """
+
+    def __init__(self, filename):
+        self.data = np.memmap(filename, dtype=np.uint8, mode="r")
+        if self.data[:8].tobytes() != MAGIC:
+            raise ValueError(f"{filename} is not a trajectory file")
+        position = 8
+        header = []
+        for _ in range(4):
+            value, position = read_varint(self.data, position)
+            header.append(value)
+        self.size_x, self.size_y, self.size_z, self.keyframe_interval = header
+        self.nb_spins = self.size_x * self.size_y * self.size_z
+
+        # Index of the records: (is keyframe, payload start, payload size), one per sweep.
+        self.records = []
+        while position < len(self.data):
+            record_type = int(self.data[position])
+            try:
+                sweep, position_size = read_varint(self.data, position + 1)
+                size, start = read_varint(self.data, position_size)
+            except EOFError:
+                break
+            if record_type not in b"KD" or sweep != len(self.records) or start + size > len(self.data):
+                break
+            self.records.append((record_type == ord("K"), start, size))
+            position = start + size
+        if not self.records or not self.records[0][0]:
+            raise ValueError(f"{filename} has no initial keyframe")
+        self._spins = None
+        self._sweep = None
+
+    @property
+    def shape(self):
+        if self.size_z > 1:
+            return (self.size_z, self.size_y, self.size_x)
+        return (self.size_y, self.size_x)
+
+    @property
+    def nb_sweeps(self):
+        return len(self.records)
+
+    def _apply(self, sweep):
+        keyframe, start, size = self.records[sweep]
+        payload = self.data[start:start + size]
+        if keyframe:
+            bits = np.unpackbits(payload, bitorder="little")[:self.nb_spins]
+            self._spins = np.where(bits == 1, 1.0, -1.0)
+        else:
+            values = decode_varints(payload)
+            nb_changed = int(values[0])
+            if len(values) != nb_changed + 1:
+                raise ValueError(f"corrupted delta record at sweep {sweep}")
+            # The gaps of the sorted indices, summed back into the indices of the changed sites.
+            indices = np.cumsum(values[1:])
+            if nb_changed > 0 and indices[-1] >= self.nb_spins:
+                raise ValueError(f"corrupted delta record at sweep {sweep}: site index out of the lattice")
+            self._spins[indices] *= -1.0
+        self._sweep = sweep
+
+    def configuration(self, sweep):
+        if not 0 <= sweep < self.nb_sweeps:
+            raise IndexError(f"sweep {sweep} is not in the trajectory ({self.nb_sweeps} sweeps)")
+        keyframe = sweep
+        while not self.records[keyframe][0]:
+            keyframe -= 1
+        if self._sweep is not None and keyframe <= self._sweep <= sweep:
+            first = self._sweep + 1
+        else:
+            self._apply(keyframe)
+            first = keyframe + 1
+        for current in range(first, sweep + 1):
+            self._apply(current)
+        return self._spins.reshape(self.shape).copy()
+
+    def __iter__(self):
+        for sweep in range(self.nb_sweeps):
+            yield self.configuration(sweep)
+
+
+if __name__ == "__main__":
+    parser = ArgumentParser(description="Rebuild configurations from an Ising trajectory file.")
+    parser.add_argument("filename")
+    parser.add_argument("--sweep", type=int, default=None, help="Sweep to rebuild (default: the last one).")
+    parser.add_argument("--output", default=None, help="Save the configuration as a .npy file.")
+    args = parser.parse_args()
+
+    reader = TrajectoryReader(args.filename)
+    nb_keyframes = sum(1 for keyframe, _, _ in reader.records if keyframe)
+    print(f"Lattice {reader.size_x}x{reader.size_y}x{reader.size_z}, {reader.nb_sweeps} sweeps, "
+          f"{nb_keyframes} keyframes, {len(reader.data)} bytes")
+    sweep = reader.nb_sweeps - 1 if args.sweep is None else args.sweep
+    spins = reader.configuration(sweep)
+    print(f"Sweep {sweep}: magnetization {spins.mean():.6f}")
+    if args.output:
+        np.save(args.output, spins)
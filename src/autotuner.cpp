@@ -0,0 +1,255 @@
+/**
+ * @file autotuner.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Runtime selection of the fastest Metropolis kernel, with a per-machine tuning cache.
+ * @version 0.1
+ * @date 2022-10-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "autotuner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string sweep_order_name(sweep_order order) {
+    switch (order) {
+        case sweep_order::sequential:
+            return "sequential";
+        case sweep_order::strided:
+            return "strided";
+        default:
+            return "random";
+    }
+}
+
+/**
+ * @brief Mean and standard error (batch means over 4 batches) of a short series.
+ */
+std::pair<double, double> mean_and_error(const std::vector<double>& values) {
+    const std::size_t nb_batches = 4;
+    const std::size_t batch_size = std::max<std::size_t>(1, values.size() / nb_batches);
+    std::vector<double> batches;
+    for (std::size_t start = 0; start + batch_size <= values.size() && batches.size() < nb_batches; start += batch_size) {
+        double sum = 0.0;
+        for (std::size_t index = start; index < start + batch_size; index++) {
+            sum += values[index];
+        }
+        batches.push_back(sum / static_cast<double>(batch_size));
+    }
+    double mean = 0.0;
+    for (double batch : batches) {
+        mean += batch;
+    }
+    mean /= static_cast<double>(batches.size());
+    if (batches.size() < 2) {
+        return {mean, 0.0};
+    }
+    double variance = 0.0;
+    for (double batch : batches) {
+        variance += (batch - mean) * (batch - mean);
+    }
+    variance /= static_cast<double>(batches.size() - 1);
+    return {mean, std::sqrt(variance / static_cast<double>(batches.size()))};
+}
+
+}  // namespace
+
+std::string to_string(const kernel_configuration& configuration) {
+    if (configuration.nb_threads > 1) {
+        return "parallel x" + std::to_string(configuration.nb_threads);
+    }
+    return sweep_order_name(configuration.order);
+}
+
+/**
+ * @brief CPU model name from /proc/cpuinfo ("unknown" if not available), without commas.
+ *
+ * @return std::string
+ */
+std::string kernel_autotuner::cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string   line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0 && line.find(':') != std::string::npos) {
+            std::string model = line.substr(line.find(':') + 1);
+            model.erase(0, model.find_first_not_of(' '));
+            std::replace(model.begin(), model.end(), ',', ' ');
+            return model;
+        }
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Location of the tuning cache.
+ *
+ * @return std::string
+ */
+std::string kernel_autotuner::get_cache_file() const {
+    if (!m_options.cache_file.empty()) {
+        return m_options.cache_file;
+    }
+    if (const char* cache_file = std::getenv("ISING_TUNE_CACHE")) {
+        return cache_file;
+    }
+    if (const char* cache_home = std::getenv("XDG_CACHE_HOME")) {
+        return std::string(cache_home) + "/ising/tuning.csv";
+    }
+    if (const char* home = std::getenv("HOME")) {
+        return std::string(home) + "/.cache/ising/tuning.csv";
+    }
+    return "ising_tuning.csv";
+}
+
+std::string kernel_autotuner::cache_key(const ising_base& lattice, int max_threads) const {
+    const auto         shape = lattice.get_shape();
+    std::ostringstream key;
+    key << cpu_model() << "," << shape[0] << "x" << shape[1] << "x" << shape[2] << "," << std::setprecision(4) << lattice.get_temperature()
+        << "," << max_threads << "," << (lattice.has_long_range_interaction() ? "long_range" : "nearest_neighbor");
+    return key.str();
+}
+
+/**
+ * @brief Candidate kernels: the serial sweep orders (the reference, serial random, first) and the parallel sweep with
+ * 2, 4, ... threads up to max_threads. The parallel sweep is not a candidate in long-range mode.
+ *
+ * @param lattice
+ * @param max_threads
+ * @return std::vector<kernel_configuration>
+ */
+std::vector<kernel_configuration> kernel_autotuner::candidates(const ising_base& lattice, int max_threads) const {
+    std::vector<kernel_configuration> configurations = {{sweep_order::random, 1}, {sweep_order::sequential, 1}, {sweep_order::strided, 1}};
+    if (lattice.has_long_range_interaction()) {
+        return configurations;
+    }
+    for (int nb_threads = 2; nb_threads < max_threads; nb_threads *= 2) {
+        configurations.push_back({sweep_order::strided, nb_threads});
+    }
+    if (max_threads > 1) {
+        configurations.push_back({sweep_order::strided, max_threads});
+    }
+    return configurations;
+}
+
+/**
+ * @brief Select the kernel of the lattice, from the cache or by benchmarking the candidates, and apply it
+ * (set_sweep_order() and set_number_threads()).
+ *
+ * File-backed lattices are rejected: the benchmark clones the lattice once per candidate, which would create full-size
+ * spin files and time out-of-core sweeps.
+ *
+ * @param lattice
+ * @return tuning_result
+ */
+tuning_result kernel_autotuner::tune(ising_base& lattice) {
+    if (lattice.is_file_backed()) {
+        throw std::invalid_argument("kernel_autotuner: file-backed lattices cannot be tuned (each candidate runs on a clone).");
+    }
+    int max_threads = m_options.max_threads;
+    if (max_threads <= 0) {
+#ifdef _OPENMP
+        max_threads = omp_get_max_threads();
+#else
+        max_threads = 1;
+#endif
+    }
+    const std::string key        = cache_key(lattice, max_threads);
+    const std::string cache_file = get_cache_file();
+    m_measurements.clear();
+
+    if (m_options.use_cache) {
+        std::ifstream cache(cache_file);
+        std::string   line;
+        bool          found = false;
+        tuning_result cached;
+        while (std::getline(cache, line)) {
+            if (line.rfind(key + ",", 0) != 0) {
+                continue;
+            }
+            std::istringstream stream(line.substr(key.size() + 1));
+            std::string        order_name, nb_threads, attempts_per_second;
+            if (std::getline(stream, order_name, ',') && std::getline(stream, nb_threads, ',') && std::getline(stream, attempts_per_second)) {
+                cached = {{parse_sweep_order(order_name), std::stoi(nb_threads)}, std::stod(attempts_per_second), true};
+                found  = true;
+            }
+        }
+        if (found) {
+            lattice.set_sweep_order(cached.configuration.order);
+            lattice.set_number_threads(cached.configuration.nb_threads);
+            return cached;
+        }
+    }
+
+    auto reference = lattice.clone();
+    reference->set_sweep_order(sweep_order::random);
+    reference->set_number_threads(1);
+    for (std::size_t sweep = 0; sweep < m_options.nb_thermalization; sweep++) {
+        reference->metropolis_step();
+    }
+    const double nb_spins = static_cast<double>(lattice.get_number_spins());
+    for (const kernel_configuration& configuration : candidates(lattice, max_threads)) {
+        auto trial = reference->clone();
+        trial->set_sweep_order(configuration.order);
+        trial->set_number_threads(configuration.nb_threads);
+        trial->metropolis_step();  // Warm-up: thread team, per-thread engines and caches.
+
+        std::vector<double> energies;
+        double              seconds = 0.0;
+        for (std::size_t sweep = 0; sweep < m_options.nb_benchmark_sweeps; sweep++) {
+            const auto start = std::chrono::steady_clock::now();
+            trial->metropolis_step();
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            energies.push_back(trial->compute_total_energy() / nb_spins);
+        }
+        const auto& spins       = trial->get_spins();
+        const bool  valid_spins = std::all_of(spins.begin(), spins.end(), [](double spin) { return spin == 1.0 || spin == -1.0; });
+        const auto [mean, error] = mean_and_error(energies);
+
+        kernel_measurement measurement{configuration,
+                                       static_cast<double>(m_options.nb_benchmark_sweeps) * nb_spins / seconds,
+                                       mean,
+                                       error,
+                                       valid_spins};
+        if (!m_measurements.empty()) {
+            // The benchmark runs are short and correlated: on top of the statistical error, allow a 2% relative
+            // difference, a broken kernel being usually far off.
+            const kernel_measurement& reference_measurement = m_measurements.front();
+            const double              statistical_error =
+                std::sqrt(error * error + reference_measurement.energy_error * reference_measurement.energy_error);
+            const double tolerance = 0.02 * std::abs(reference_measurement.mean_energy) + 1.0e-3 + 4.0 * statistical_error;
+            measurement.equivalent = measurement.equivalent && std::abs(mean - reference_measurement.mean_energy) <= tolerance;
+        }
+        m_measurements.push_back(measurement);
+    }
+
+    auto best = std::max_element(m_measurements.begin(), m_measurements.end(), [](const kernel_measurement& a, const kernel_measurement& b) {
+        return (a.equivalent ? a.attempts_per_second : 0.0) < (b.equivalent ? b.attempts_per_second : 0.0);
+    });
+    tuning_result result{best->configuration, best->attempts_per_second, false};
+    lattice.set_sweep_order(result.configuration.order);
+    lattice.set_number_threads(result.configuration.nb_threads);
+
+    if (m_options.use_cache) {
+        const std::filesystem::path path(cache_file);
+        if (path.has_parent_path()) {
+            std::error_code error;
+            std::filesystem::create_directories(path.parent_path(), error);
+        }
+        std::ofstream cache(cache_file, std::ios::app);
+        cache << key << "," << sweep_order_name(result.configuration.order) << "," << result.configuration.nb_threads << ","
+              << result.attempts_per_second << "\n";
+    }
+    return result;
+}
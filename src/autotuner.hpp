@@ -0,0 +1,93 @@
+/**
+ * @file autotuner.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Runtime selection of the fastest Metropolis kernel, with a per-machine tuning cache.
+ * @version 0.1
+ * @date 2022-10-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "ising_base.hpp"
+
+/**
+ * @brief A Metropolis kernel: sweep order and number of threads (more than one thread selects the parallel sweep).
+ *
+ */
+struct kernel_configuration {
+    sweep_order order      = sweep_order::random;
+    int         nb_threads = 1;
+};
+
+std::string to_string(const kernel_configuration& configuration);
+
+/**
+ * @brief Benchmark of one candidate kernel.
+ *
+ * mean_energy is the mean of compute_total_energy() / N over the benchmark sweeps. equivalent is false when it is not
+ * compatible with the one of the reference kernel (serial random sweeps), or when the kernel produced spins other than
+ * +1 and -1, in which case the candidate is never selected.
+ */
+struct kernel_measurement {
+    kernel_configuration configuration;
+    double               attempts_per_second = 0.0;
+    double               mean_energy         = 0.0;
+    double               energy_error        = 0.0;
+    bool                 equivalent          = false;
+};
+
+struct tuning_result {
+    kernel_configuration configuration;
+    double               attempts_per_second = 0.0;
+    bool                 from_cache          = false;
+};
+
+/**
+ * @brief Settings of the autotuner.
+ *
+ * - max_threads: largest thread count tried by the parallel candidates (0: omp_get_max_threads()).
+ * - nb_thermalization: sweeps of the reference kernel before the benchmarks, so that all the candidates start from
+ *   the same equilibrated configuration.
+ * - nb_benchmark_sweeps: sweeps of each candidate, used both for its timing and for its equivalence check.
+ * - cache_file: tuning cache (empty: $ISING_TUNE_CACHE, else $XDG_CACHE_HOME/ising/tuning.csv, else
+ *   ~/.cache/ising/tuning.csv). use_cache = false always benchmarks and does not write the cache.
+ */
+struct autotune_options {
+    int         max_threads         = 0;
+    std::size_t nb_thermalization   = 50;
+    std::size_t nb_benchmark_sweeps = 40;
+    std::string cache_file          = "";
+    bool        use_cache           = true;
+};
+
+/**
+ * @brief Micro-benchmark the candidate metropolis_step() kernels on clones of the actual lattice and apply the fastest
+ * one that passes the equivalence check.
+ *
+ * The decision is cached in a local CSV file keyed by CPU model, lattice shape, temperature, maximum thread count and
+ * interaction mode, so that later runs on the same machine and problem start tuned without benchmarking.
+ */
+class kernel_autotuner {
+ private:
+    autotune_options                m_options;
+    std::vector<kernel_measurement> m_measurements;
+
+    std::string                       cache_key(const ising_base& lattice, int max_threads) const;
+    std::vector<kernel_configuration> candidates(const ising_base& lattice, int max_threads) const;
+
+ public:
+    explicit kernel_autotuner(const autotune_options& options = {}) : m_options(options) {}
+
+    tuning_result tune(ising_base& lattice);
+
+    const std::vector<kernel_measurement>& get_measurements() const { return m_measurements; }
+
+    std::string        get_cache_file() const;
+    static std::string cpu_model();
+};
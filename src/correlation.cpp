@@ -0,0 +1,182 @@
+/**
+ * @file correlation.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-situ measurement of the spin-spin correlation function and of the structure factor.
+ * @version 0.1
+ * @date 2022-09-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "correlation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+/**
+ * @brief Construct a new correlation analyzer::correlation analyzer object.
+ *
+ * The distances are binned with a width of one lattice spacing up to half the smallest non-trivial dimension, the
+ * wave numbers with a width of 2 pi / L_min up to pi.
+ *
+ * @param shape Lattice dimensions {size_x, size_y, size_z}.
+ */
+correlation_analyzer::correlation_analyzer(const std::array<std::size_t, 3>& shape)
+    : m_shape(shape),
+      m_plan(shape),
+      m_buffer(shape[0] * shape[1] * shape[2]),
+      m_distance_bins(m_buffer.size()),
+      m_wave_number_bins(m_buffer.size()) {
+    std::size_t min_size = 0;
+    for (std::size_t size : m_shape) {
+        if (size > 1) {
+            min_size = min_size == 0 ? size : std::min(min_size, size);
+        }
+    }
+    min_size                   = std::max<std::size_t>(min_size, 1);
+    const std::size_t nb_bins  = min_size / 2 + 1;
+    const double      dk       = 2.0 * M_PI / static_cast<double>(min_size);
+    const std::size_t no_bin   = nb_bins;
+    m_distance_counts.assign(nb_bins, 0.0);
+    m_wave_number_counts.assign(nb_bins, 0.0);
+
+    for (std::size_t z = 0; z < m_shape[2]; z++) {
+        for (std::size_t y = 0; y < m_shape[1]; y++) {
+            for (std::size_t x = 0; x < m_shape[0]; x++) {
+                const std::array<std::size_t, 3> position = {x, y, z};
+                double                           r2       = 0.0;
+                double                           k2       = 0.0;
+                for (std::size_t axis = 0; axis < 3; axis++) {
+                    // Minimum image displacement, and the corresponding signed frequency index.
+                    const double n = static_cast<double>(std::min(position[axis], m_shape[axis] - position[axis]));
+                    const double k = 2.0 * M_PI * n / static_cast<double>(m_shape[axis]);
+                    r2 += n * n;
+                    k2 += k * k;
+                }
+                const std::size_t index        = x + y * m_shape[0] + z * m_shape[0] * m_shape[1];
+                const std::size_t distance_bin = static_cast<std::size_t>(std::lround(std::sqrt(r2)));
+                const std::size_t k_bin        = static_cast<std::size_t>(std::lround(std::sqrt(k2) / dk));
+                m_distance_bins[index]         = distance_bin < nb_bins ? distance_bin : no_bin;
+                m_wave_number_bins[index]      = k_bin < nb_bins ? k_bin : no_bin;
+                if (distance_bin < nb_bins) {
+                    m_distance_counts[distance_bin] += 1.0;
+                }
+                if (k_bin < nb_bins) {
+                    m_wave_number_counts[k_bin] += 1.0;
+                }
+            }
+        }
+    }
+
+    m_measurement.distances.resize(nb_bins);
+    m_measurement.wave_numbers.resize(nb_bins);
+    for (std::size_t bin = 0; bin < nb_bins; bin++) {
+        m_measurement.distances[bin]    = static_cast<double>(bin);
+        m_measurement.wave_numbers[bin] = dk * static_cast<double>(bin);
+    }
+    m_measurement.correlation.resize(nb_bins);
+    m_measurement.connected_correlation.resize(nb_bins);
+    m_measurement.structure_factor.resize(nb_bins);
+}
+
+/**
+ * @brief Measure the correlations of a configuration.
+ *
+ * With unnormalized transforms, S(k) = |s(k)|^2 / N and G(r) = IFFT(|s(k)|^2)(r) / N^2. The correlation length is the
+ * second-moment estimator xi = sqrt(S(0) / S(k_min) - 1) / (2 sin(k_min / 2)), averaged over the axes (infinite for a
+ * fully ordered configuration).
+ *
+ * @param spins Configuration, x being the fastest axis.
+ * @return const correlation_measurement&
+ */
+const correlation_measurement& correlation_analyzer::measure(const double* spins) {
+    const std::size_t nb_spins = m_buffer.size();
+    const double      n        = static_cast<double>(nb_spins);
+    std::copy(spins, spins + nb_spins, m_buffer.begin());
+    m_plan.forward(m_buffer);
+
+    const std::size_t nb_bins = m_measurement.structure_factor.size();
+    std::fill(m_measurement.structure_factor.begin(), m_measurement.structure_factor.end(), 0.0);
+    for (std::size_t index = 0; index < nb_spins; index++) {
+        const double power = std::norm(m_buffer[index]);
+        m_buffer[index]    = power;
+        if (m_wave_number_bins[index] < nb_bins) {
+            m_measurement.structure_factor[m_wave_number_bins[index]] += power / n;
+        }
+    }
+    const double structure_factor_zero = m_buffer[0].real() / n;
+
+    double      sum_xi  = 0.0;
+    std::size_t nb_axes = 0;
+    std::size_t stride  = 1;
+    for (std::size_t axis = 0; axis < 3; axis++) {
+        if (m_shape[axis] > 1) {
+            const double k_min         = 2.0 * M_PI / static_cast<double>(m_shape[axis]);
+            const double structure_min = 0.5 * (m_buffer[stride].real() + m_buffer[(m_shape[axis] - 1) * stride].real()) / n;
+            // A (numerically) vanishing S(k_min) means a fully ordered configuration: the length diverges.
+            if (structure_min <= 1.0e-12 * structure_factor_zero) {
+                sum_xi = std::numeric_limits<double>::infinity();
+            } else if (structure_factor_zero > structure_min) {
+                sum_xi += std::sqrt(structure_factor_zero / structure_min - 1.0) / (2.0 * std::sin(k_min / 2.0));
+            }
+            nb_axes++;
+        }
+        stride *= m_shape[axis];
+    }
+    m_measurement.correlation_length = nb_axes > 0 ? sum_xi / nb_axes : 0.0;
+
+    m_plan.inverse(m_buffer);
+    m_measurement.magnetization = std::sqrt(structure_factor_zero / n);
+    const double magnetization_square = structure_factor_zero / n;
+    std::fill(m_measurement.correlation.begin(), m_measurement.correlation.end(), 0.0);
+    for (std::size_t index = 0; index < nb_spins; index++) {
+        if (m_distance_bins[index] < nb_bins) {
+            m_measurement.correlation[m_distance_bins[index]] += m_buffer[index].real() / (n * n);
+        }
+    }
+    for (std::size_t bin = 0; bin < nb_bins; bin++) {
+        if (m_distance_counts[bin] > 0.0) {
+            m_measurement.correlation[bin] /= m_distance_counts[bin];
+        }
+        if (m_wave_number_counts[bin] > 0.0) {
+            m_measurement.structure_factor[bin] /= m_wave_number_counts[bin];
+        }
+        m_measurement.connected_correlation[bin] = m_measurement.correlation[bin] - magnetization_square;
+    }
+    return m_measurement;
+}
+
+/**
+ * @brief Construct a new correlation recorder::correlation recorder object and write the CSV headers.
+ *
+ * @param filename Prefix of the output files.
+ * @param shape
+ */
+correlation_recorder::correlation_recorder(const std::string& filename, const std::array<std::size_t, 3>& shape)
+    : m_analyzer(shape),
+      m_profiles_file(filename + "_correlation.csv"),
+      m_length_file(filename + "_correlation_length.csv") {
+    m_profiles_file << std::setprecision(10);
+    m_length_file << std::setprecision(10);
+    m_profiles_file << "iteration,r,correlation,connected_correlation,k,structure_factor\n";
+    m_length_file << "iteration,abs_magnetization,correlation_length\n";
+}
+
+/**
+ * @brief Measure the configuration and append the results to the output files.
+ *
+ * @param iteration
+ * @param spins
+ */
+void correlation_recorder::record(std::size_t iteration, const double* spins) {
+    const correlation_measurement& measurement = m_analyzer.measure(spins);
+    for (std::size_t bin = 0; bin < measurement.distances.size(); bin++) {
+        m_profiles_file << iteration << "," << measurement.distances[bin] << "," << measurement.correlation[bin] << ","
+                        << measurement.connected_correlation[bin] << "," << measurement.wave_numbers[bin] << ","
+                        << measurement.structure_factor[bin] << "\n";
+    }
+    m_length_file << iteration << "," << measurement.magnetization << "," << measurement.correlation_length << "\n";
+}
@@ -0,0 +1,76 @@
+/**
+ * @file correlation.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-situ measurement of the spin-spin correlation function and of the structure factor.
+ * @version 0.1
+ * @date 2022-09-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "fft.hpp"
+
+/**
+ * @brief Radially averaged correlations of one configuration.
+ *
+ * correlation[i] is G(r) = <s_j s_{j+r}> averaged over the displacements with |r| closest to distances[i] (minimum
+ * image), connected_correlation[i] is G(r) - m^2. structure_factor[i] is S(k) = |s(k)|^2 / N averaged over the
+ * wave vectors with |k| closest to wave_numbers[i].
+ */
+struct correlation_measurement {
+    std::vector<double> distances;
+    std::vector<double> correlation;
+    std::vector<double> connected_correlation;
+    std::vector<double> wave_numbers;
+    std::vector<double> structure_factor;
+    double              magnetization      = 0.0;
+    double              correlation_length = 0.0;
+};
+
+/**
+ * @brief Compute G(r), S(k) and the second-moment correlation length with FFTs.
+ *
+ * The FFT plan, the complex buffer and the radial binning of the lattice are built once and reused by every
+ * measurement, so that measuring every few sweeps does not allocate.
+ */
+class correlation_analyzer {
+ private:
+    std::array<std::size_t, 3> m_shape;
+    fft_plan_nd                m_plan;
+    complex_vector             m_buffer;
+    std::vector<std::size_t>   m_distance_bins;
+    std::vector<std::size_t>   m_wave_number_bins;
+    std::vector<double>        m_distance_counts;
+    std::vector<double>        m_wave_number_counts;
+    correlation_measurement    m_measurement;
+
+ public:
+    explicit correlation_analyzer(const std::array<std::size_t, 3>& shape);
+
+    const correlation_measurement& measure(const double* spins);
+};
+
+/**
+ * @brief Write the radially averaged profiles (filename_correlation.csv) and the correlation length
+ * (filename_correlation_length.csv) measured along a simulation.
+ *
+ */
+class correlation_recorder {
+ private:
+    correlation_analyzer m_analyzer;
+    std::ofstream        m_profiles_file;
+    std::ofstream        m_length_file;
+
+ public:
+    correlation_recorder(const std::string& filename, const std::array<std::size_t, 3>& shape);
+
+    void record(std::size_t iteration, const double* spins);
+};
@@ -0,0 +1,218 @@
+/**
+ * @file domains.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-situ labeling of the same-spin domains (parallel Hoshen-Kopelman) and of their interfaces.
+ * @version 0.1
+ * @date 2022-10-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "domains.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::size_t log2_floor(std::size_t value) {
+    std::size_t result = 0;
+    while (value >>= 1) {
+        result++;
+    }
+    return result;
+}
+
+}  // namespace
+
+/**
+ * @brief Construct a new domain analyzer::domain analyzer object.
+ *
+ * The slabs are cut along the slowest axis of size larger than one (z in 3D, y in 2D). The bonds may only move by
+ * zero or one plane along that axis.
+ *
+ * @param shape Lattice dimensions {size_x, size_y, size_z}.
+ * @param bonds Forward displacements of the bonds.
+ * @param nb_threads Number of threads (and of slabs, at most one per plane) of the labeling.
+ */
+domain_analyzer::domain_analyzer(const std::array<std::size_t, 3>&              shape,
+                                 const std::vector<std::array<std::size_t, 3>>& bonds,
+                                 int                                            nb_threads)
+    : m_shape(shape),
+      m_bonds(bonds),
+      m_nb_threads(std::max(nb_threads, 1)),
+      m_parent(shape[0] * shape[1] * shape[2]) {
+    const std::size_t slab_axis = m_shape[2] > 1 ? 2 : 1;
+    for (const auto& bond : m_bonds) {
+        if (bond[slab_axis] > 1) {
+            throw std::invalid_argument("domain_analyzer: bonds must span at most one plane along the slab axis.");
+        }
+    }
+    m_measurement.size_histogram.resize(log2_floor(std::max<std::size_t>(m_parent.size(), 1)) + 1);
+}
+
+/**
+ * @brief Root of the tree of index, with path halving.
+ *
+ * @param index
+ * @return std::int64_t
+ */
+std::int64_t domain_analyzer::find_root(std::int64_t index) {
+    while (m_parent[index] >= 0) {
+        const std::int64_t parent = m_parent[index];
+        if (m_parent[parent] >= 0) {
+            m_parent[index] = m_parent[parent];
+        }
+        index = m_parent[index];
+    }
+    return index;
+}
+
+/**
+ * @brief Union by size of the domains of two sites.
+ *
+ * @param first
+ * @param second
+ */
+void domain_analyzer::merge(std::int64_t first, std::int64_t second) {
+    std::int64_t first_root  = find_root(first);
+    std::int64_t second_root = find_root(second);
+    if (first_root == second_root) {
+        return;
+    }
+    // Roots hold minus the size of their domain: attach the smaller domain to the larger one.
+    if (m_parent[first_root] > m_parent[second_root]) {
+        std::swap(first_root, second_root);
+    }
+    m_parent[first_root] += m_parent[second_root];
+    m_parent[second_root] = first_root;
+}
+
+/**
+ * @brief Label the domains of a configuration and compute their statistics.
+ *
+ * @param spins Spins in the storage order of the lattice (x is the fastest axis).
+ * @return const domain_measurement& Valid until the next measurement.
+ */
+const domain_measurement& domain_analyzer::measure(const double* spins) {
+    const std::size_t slab_axis  = m_shape[2] > 1 ? 2 : 1;
+    const std::size_t nb_planes  = m_shape[slab_axis];
+    const std::size_t plane_size = m_parent.size() / nb_planes;
+    const std::size_t size_xy    = m_shape[0] * m_shape[1];
+
+    auto neighbor = [&](std::size_t x, std::size_t y, std::size_t z, const std::array<std::size_t, 3>& bond) {
+        return (x + bond[0]) % m_shape[0] + ((y + bond[1]) % m_shape[1]) * m_shape[0] + ((z + bond[2]) % m_shape[2]) * size_xy;
+    };
+
+    const std::size_t nb_slabs = std::min<std::size_t>(static_cast<std::size_t>(m_nb_threads), nb_planes);
+
+    // Union-find inside each slab: the trees of a slab only contain its own sites, so the slabs are independent.
+    std::size_t interface_length = 0;
+#pragma omp parallel for num_threads(static_cast<int>(nb_slabs)) schedule(static, 1) reduction(+ : interface_length)
+    for (std::size_t slab = 0; slab < nb_slabs; slab++) {
+        const std::size_t first_plane = slab * nb_planes / nb_slabs;
+        const std::size_t last_plane  = (slab + 1) * nb_planes / nb_slabs;
+        std::fill(m_parent.begin() + first_plane * plane_size, m_parent.begin() + last_plane * plane_size, -1);
+        for (std::size_t index = first_plane * plane_size; index < last_plane * plane_size; index++) {
+            const std::size_t x     = index % m_shape[0];
+            const std::size_t y     = (index / m_shape[0]) % m_shape[1];
+            const std::size_t z     = index / size_xy;
+            const std::size_t plane = slab_axis == 2 ? z : y;
+            for (const auto& bond : m_bonds) {
+                const std::size_t other = neighbor(x, y, z, bond);
+                if (spins[other] != spins[index]) {
+                    interface_length++;
+                } else if (plane + bond[slab_axis] < last_plane) {
+                    merge(static_cast<std::int64_t>(index), static_cast<std::int64_t>(other));
+                }
+            }
+        }
+    }
+
+    // Bonds leaving the last plane of each slab, towards the next slab (the first one through the periodic boundary).
+    for (std::size_t slab = 0; slab < nb_slabs; slab++) {
+        const std::size_t last_plane = (slab + 1) * nb_planes / nb_slabs;
+        for (std::size_t index = (last_plane - 1) * plane_size; index < last_plane * plane_size; index++) {
+            const std::size_t x = index % m_shape[0];
+            const std::size_t y = (index / m_shape[0]) % m_shape[1];
+            const std::size_t z = index / size_xy;
+            for (const auto& bond : m_bonds) {
+                const std::size_t other = neighbor(x, y, z, bond);
+                if (bond[slab_axis] == 1 && spins[other] == spins[index]) {
+                    merge(static_cast<std::int64_t>(index), static_cast<std::int64_t>(other));
+                }
+            }
+        }
+    }
+
+    // Statistics over the roots.
+    const std::size_t        nb_bins = m_measurement.size_histogram.size();
+    std::vector<std::size_t> histogram(nb_bins, 0);
+    std::size_t              nb_domains = 0;
+    std::size_t              largest    = 0;
+#pragma omp parallel num_threads(m_nb_threads) reduction(+ : nb_domains) reduction(max : largest)
+    {
+        std::vector<std::size_t> thread_histogram(nb_bins, 0);
+#pragma omp for schedule(static)
+        for (std::size_t index = 0; index < m_parent.size(); index++) {
+            if (m_parent[index] < 0) {
+                const std::size_t size = static_cast<std::size_t>(-m_parent[index]);
+                nb_domains++;
+                largest = std::max(largest, size);
+                thread_histogram[log2_floor(size)]++;
+            }
+        }
+#pragma omp critical
+        for (std::size_t bin = 0; bin < nb_bins; bin++) {
+            histogram[bin] += thread_histogram[bin];
+        }
+    }
+
+    m_measurement.nb_domains              = nb_domains;
+    m_measurement.largest_domain_size     = largest;
+    m_measurement.largest_domain_fraction = static_cast<double>(largest) / static_cast<double>(m_parent.size());
+    m_measurement.interface_length        = interface_length;
+    m_measurement.size_histogram          = histogram;
+    return m_measurement;
+}
+
+/**
+ * @brief Construct a new domain recorder::domain recorder object.
+ *
+ * The size histogram takes one column per power of two: size_<s> counts the domains of size in [s, 2 s).
+ *
+ * @param filename
+ * @param shape
+ * @param bonds
+ * @param nb_threads
+ */
+domain_recorder::domain_recorder(const std::string&                             filename,
+                                 const std::array<std::size_t, 3>&              shape,
+                                 const std::vector<std::array<std::size_t, 3>>& bonds,
+                                 int                                            nb_threads)
+    : m_analyzer(shape, bonds, nb_threads),
+      m_file(filename + "_domains.csv"),
+      m_nb_bins(log2_floor(std::max<std::size_t>(shape[0] * shape[1] * shape[2], 1)) + 1) {
+    m_file << "iteration,nb_domains,largest_domain_fraction,interface_length";
+    for (std::size_t bin = 0; bin < m_nb_bins; bin++) {
+        m_file << ",size_" << (std::size_t{1} << bin);
+    }
+    m_file << "\n";
+}
+
+/**
+ * @brief Measure the domains of the configuration and append them to the file.
+ *
+ * @param iteration
+ * @param spins
+ */
+void domain_recorder::record(std::size_t iteration, const double* spins) {
+    const domain_measurement& measurement = m_analyzer.measure(spins);
+    m_file << iteration << "," << measurement.nb_domains << "," << measurement.largest_domain_fraction << "," << measurement.interface_length;
+    for (std::size_t count : measurement.size_histogram) {
+        m_file << "," << count;
+    }
+    m_file << "\n";
+}
@@ -0,0 +1,81 @@
+/**
+ * @file domains.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-situ labeling of the same-spin domains (parallel Hoshen-Kopelman) and of their interfaces.
+ * @version 0.1
+ * @date 2022-10-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Domain statistics of one configuration.
+ *
+ * A domain is a connected set of equal spins, two sites being connected when they share a bond of the Hamiltonian
+ * (periodic boundaries included). size_histogram[b] is the number of domains of size in [2^b, 2^(b+1)).
+ * interface_length is the number of bonds between opposite spins (the interface area in 3D).
+ */
+struct domain_measurement {
+    std::size_t              nb_domains              = 0;
+    std::size_t              largest_domain_size     = 0;
+    double                   largest_domain_fraction = 0.0;
+    std::size_t              interface_length        = 0;
+    std::vector<std::size_t> size_histogram;
+};
+
+/**
+ * @brief Label the domains with a tiled, parallel Hoshen-Kopelman pass.
+ *
+ * The lattice is cut into slabs of consecutive planes (rows in 2D), one per thread of the analyzer. Each thread runs the
+ * union-find of the bonds inside its slab, then the bonds across the slab boundaries are merged serially, which touches
+ * a single plane per slab. Roots store minus the size of their domain, so the statistics are a parallel reduction over
+ * the roots and no relabeling pass is needed. The union-find array is allocated once and reused by every measurement.
+ */
+class domain_analyzer {
+ private:
+    std::array<std::size_t, 3>              m_shape;
+    std::vector<std::array<std::size_t, 3>> m_bonds;
+    int                                     m_nb_threads;
+    std::vector<std::int64_t>               m_parent;
+    domain_measurement                      m_measurement;
+
+    std::int64_t find_root(std::int64_t index);
+    void         merge(std::int64_t first, std::int64_t second);
+
+ public:
+    /**
+     * @brief Analyzer of a lattice of the given shape, with the bonds given as forward displacements (each bond of the
+     * Hamiltonian appears once, e.g. {1, 0, 0} and {0, 1, 0} for the square lattice), labeled with nb_threads threads.
+     */
+    domain_analyzer(const std::array<std::size_t, 3>& shape, const std::vector<std::array<std::size_t, 3>>& bonds, int nb_threads = 1);
+
+    const domain_measurement& measure(const double* spins);
+};
+
+/**
+ * @brief Write one line of domain statistics per measurement to filename_domains.csv.
+ *
+ */
+class domain_recorder {
+ private:
+    domain_analyzer m_analyzer;
+    std::ofstream   m_file;
+    std::size_t     m_nb_bins;
+
+ public:
+    domain_recorder(const std::string&                             filename,
+                    const std::array<std::size_t, 3>&              shape,
+                    const std::vector<std::array<std::size_t, 3>>& bonds,
+                    int                                            nb_threads = 1);
+
+    void record(std::size_t iteration, const double* spins);
+};
@@ -0,0 +1,186 @@
+/**
+ * @file fft.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Small in-tree FFT: radix-2 for powers of two and Bluestein's algorithm for other lengths.
+ * @version 0.1
+ * @date 2022-09-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+bool is_power_of_two(std::size_t value) { return value > 0 && (value & (value - 1)) == 0; }
+
+std::size_t next_power_of_two(std::size_t value) {
+    std::size_t power = 1;
+    while (power < value) {
+        power <<= 1;
+    }
+    return power;
+}
+
+}  // namespace
+
+/**
+ * @brief Construct a new fft radix2::fft radix2 object.
+ *
+ * @param size Length of the transform, must be a power of two.
+ */
+fft_radix2::fft_radix2(std::size_t size) : m_size(size), m_bit_reversal(size), m_twiddles(size / 2) {
+    std::size_t nb_bits = 0;
+    while ((std::size_t{1} << nb_bits) < size) {
+        nb_bits++;
+    }
+    for (std::size_t index = 0; index < size; index++) {
+        std::size_t reversed = 0;
+        for (std::size_t bit = 0; bit < nb_bits; bit++) {
+            reversed |= ((index >> bit) & 1) << (nb_bits - 1 - bit);
+        }
+        m_bit_reversal[index] = reversed;
+    }
+    for (std::size_t index = 0; index < size / 2; index++) {
+        m_twiddles[index] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(index) / static_cast<double>(size));
+    }
+}
+
+/**
+ * @brief In-place transform (forward: exp(-2i pi jk / n), inverse: exp(+2i pi jk / n), no normalization).
+ *
+ * @param data
+ * @param inverse
+ */
+void fft_radix2::transform(std::complex<double>* data, bool inverse) const {
+    for (std::size_t index = 0; index < m_size; index++) {
+        if (index < m_bit_reversal[index]) {
+            std::swap(data[index], data[m_bit_reversal[index]]);
+        }
+    }
+    for (std::size_t length = 2; length <= m_size; length <<= 1) {
+        const std::size_t half        = length / 2;
+        const std::size_t twiddle_step = m_size / length;
+        for (std::size_t start = 0; start < m_size; start += length) {
+            for (std::size_t k = 0; k < half; k++) {
+                const std::complex<double> twiddle = inverse ? std::conj(m_twiddles[k * twiddle_step]) : m_twiddles[k * twiddle_step];
+                const std::complex<double> even    = data[start + k];
+                const std::complex<double> odd     = data[start + k + half] * twiddle;
+                data[start + k]                    = even + odd;
+                data[start + k + half]             = even - odd;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Construct a new fft plan 1d::fft plan 1d object.
+ *
+ * For lengths which are not powers of two, the transform is expressed as a circular convolution with a chirp
+ * (Bluestein), computed with a radix-2 transform of length >= 2n - 1.
+ *
+ * @param size
+ */
+fft_plan_1d::fft_plan_1d(std::size_t size) : m_size(size), m_power_of_two(is_power_of_two(size)) {
+    if (m_power_of_two) {
+        m_radix2 = fft_radix2(size);
+        return;
+    }
+    const std::size_t padded_size = next_power_of_two(2 * size - 1);
+    m_radix2                      = fft_radix2(padded_size);
+    m_chirp.resize(size);
+    for (std::size_t k = 0; k < size; k++) {
+        // k^2 is reduced modulo 2n to keep the phase accurate for large k.
+        const std::size_t k_square = (k * k) % (2 * size);
+        m_chirp[k]                 = std::polar(1.0, -M_PI * static_cast<double>(k_square) / static_cast<double>(size));
+    }
+    m_chirp_filter.assign(padded_size, 0.0);
+    m_chirp_filter[0] = std::conj(m_chirp[0]);
+    for (std::size_t k = 1; k < size; k++) {
+        m_chirp_filter[k]               = std::conj(m_chirp[k]);
+        m_chirp_filter[padded_size - k] = std::conj(m_chirp[k]);
+    }
+    m_radix2.transform(m_chirp_filter.data(), false);
+    m_scratch.resize(padded_size);
+}
+
+/**
+ * @brief In-place unnormalized transform of data[0..n).
+ *
+ * @param data
+ * @param inverse
+ */
+void fft_plan_1d::execute(std::complex<double>* data, bool inverse) {
+    if (m_power_of_two) {
+        m_radix2.transform(data, inverse);
+        return;
+    }
+    // The inverse transform is computed as conj(DFT(conj(x))).
+    const std::size_t padded_size = m_scratch.size();
+    for (std::size_t k = 0; k < m_size; k++) {
+        m_scratch[k] = (inverse ? std::conj(data[k]) : data[k]) * m_chirp[k];
+    }
+    std::fill(m_scratch.begin() + m_size, m_scratch.end(), 0.0);
+    m_radix2.transform(m_scratch.data(), false);
+    for (std::size_t k = 0; k < padded_size; k++) {
+        m_scratch[k] *= m_chirp_filter[k];
+    }
+    m_radix2.transform(m_scratch.data(), true);
+    const double normalization = 1.0 / static_cast<double>(padded_size);
+    for (std::size_t k = 0; k < m_size; k++) {
+        const std::complex<double> value = m_scratch[k] * m_chirp[k] * normalization;
+        data[k]                          = inverse ? std::conj(value) : value;
+    }
+}
+
+/**
+ * @brief Construct a new fft plan nd::fft plan nd object.
+ *
+ * @param shape
+ */
+fft_plan_nd::fft_plan_nd(const std::array<std::size_t, 3>& shape) : m_shape(shape) {
+    for (std::size_t size : m_shape) {
+        m_plans.emplace_back(size);
+    }
+    m_line.resize(*std::max_element(m_shape.begin(), m_shape.end()));
+}
+
+/**
+ * @brief Transform along every axis of size > 1. Each line is gathered into a contiguous buffer before its transform.
+ *
+ * @param data
+ * @param inverse
+ */
+void fft_plan_nd::transform(complex_vector& data, bool inverse) {
+    const std::array<std::size_t, 3> strides = {1, m_shape[0], m_shape[0] * m_shape[1]};
+    for (std::size_t axis = 0; axis < 3; axis++) {
+        const std::size_t length = m_shape[axis];
+        if (length == 1) {
+            continue;
+        }
+        const std::size_t stride = strides[axis];
+        const std::size_t total  = size();
+        for (std::size_t start = 0; start < total; start++) {
+            // Only the first element of every line along the axis starts a transform.
+            if ((start / stride) % length != 0) {
+                continue;
+            }
+            if (axis == 0) {
+                m_plans[0].execute(data.data() + start, inverse);
+                start += length - 1;
+                continue;
+            }
+            for (std::size_t index = 0; index < length; index++) {
+                m_line[index] = data[start + index * stride];
+            }
+            m_plans[axis].execute(m_line.data(), inverse);
+            for (std::size_t index = 0; index < length; index++) {
+                data[start + index * stride] = m_line[index];
+            }
+        }
+    }
+}
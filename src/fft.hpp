@@ -0,0 +1,83 @@
+/**
+ * @file fft.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Small in-tree FFT: radix-2 for powers of two and Bluestein's algorithm for other lengths.
+ * @version 0.1
+ * @date 2022-09-19
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <complex>
+#include <vector>
+
+#include "spin_allocator.hpp"
+
+using complex_vector = std::vector<std::complex<double>, spin_allocator<std::complex<double>>>;
+
+/**
+ * @brief Iterative in-place radix-2 transform of a fixed power-of-two length.
+ *
+ */
+class fft_radix2 {
+ private:
+    std::size_t              m_size = 0;
+    std::vector<std::size_t> m_bit_reversal;
+    complex_vector           m_twiddles;
+
+ public:
+    fft_radix2() = default;
+    explicit fft_radix2(std::size_t size);
+
+    std::size_t size() const { return m_size; }
+    void        transform(std::complex<double>* data, bool inverse) const;
+};
+
+/**
+ * @brief Plan for the unnormalized 1D discrete Fourier transform of any length.
+ *
+ * Twiddles, chirps and scratch buffers are computed once at construction and reused by every execution.
+ * A plan is therefore not thread-safe, each thread must use its own copy.
+ */
+class fft_plan_1d {
+ private:
+    std::size_t    m_size;
+    bool           m_power_of_two;
+    fft_radix2     m_radix2;
+    complex_vector m_chirp;
+    complex_vector m_chirp_filter;
+    complex_vector m_scratch;
+
+ public:
+    explicit fft_plan_1d(std::size_t size);
+
+    std::size_t size() const { return m_size; }
+    void        execute(std::complex<double>* data, bool inverse);
+};
+
+/**
+ * @brief Plan for the unnormalized multi-dimensional transform of arrays of shape {size_x, size_y, size_z}, x being the
+ * fastest axis. Axes of size 1 are skipped.
+ *
+ */
+class fft_plan_nd {
+ private:
+    std::array<std::size_t, 3> m_shape;
+    std::vector<fft_plan_1d>   m_plans;
+    complex_vector             m_line;
+
+    void transform(complex_vector& data, bool inverse);
+
+ public:
+    explicit fft_plan_nd(const std::array<std::size_t, 3>& shape);
+
+    const std::array<std::size_t, 3>& shape() const { return m_shape; }
+    std::size_t                       size() const { return m_shape[0] * m_shape[1] * m_shape[2]; }
+
+    void forward(complex_vector& data) { transform(data, false); }
+    void inverse(complex_vector& data) { transform(data, true); }
+};
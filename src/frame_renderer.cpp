@@ -0,0 +1,422 @@
+/**
+ * @file frame_renderer.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-process rendering of spin configurations to PPM, PNG and animated GIF images.
+ * @version 0.1
+ * @date 2022-09-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "frame_renderer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+void write_u32_big_endian(std::string& buffer, std::uint32_t value) {
+    buffer.push_back(static_cast<char>((value >> 24) & 0xFF));
+    buffer.push_back(static_cast<char>((value >> 16) & 0xFF));
+    buffer.push_back(static_cast<char>((value >> 8) & 0xFF));
+    buffer.push_back(static_cast<char>(value & 0xFF));
+}
+
+void write_u16_little_endian(std::ostream& stream, std::size_t value) {
+    stream.put(static_cast<char>(value & 0xFF));
+    stream.put(static_cast<char>((value >> 8) & 0xFF));
+}
+
+std::uint32_t crc32(const std::string& data, std::size_t offset) {
+    static const std::array<std::uint32_t, 256> table = [] {
+        std::array<std::uint32_t, 256> crc_table{};
+        for (std::uint32_t n = 0; n < 256; n++) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            crc_table[n] = c;
+        }
+        return crc_table;
+    }();
+    std::uint32_t crc = 0xFFFFFFFFu;
+    for (std::size_t index = offset; index < data.size(); index++) {
+        crc = table[(crc ^ static_cast<std::uint8_t>(data[index])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void write_png_chunk(std::ostream& stream, const char* type, const std::string& data) {
+    std::string chunk;
+    write_u32_big_endian(chunk, static_cast<std::uint32_t>(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+    write_u32_big_endian(chunk, crc32(chunk, 4));
+    stream.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+}
+
+/**
+ * @brief LSB-first variable-width code packer, flushed as GIF sub-blocks of at most 255 bytes.
+ *
+ */
+class gif_code_packer {
+ private:
+    std::ostream&             m_stream;
+    std::uint32_t             m_bits     = 0;
+    int                       m_nb_bits  = 0;
+    std::vector<std::uint8_t> m_block;
+
+    void flush_block() {
+        m_stream.put(static_cast<char>(m_block.size()));
+        m_stream.write(reinterpret_cast<const char*>(m_block.data()), static_cast<std::streamsize>(m_block.size()));
+        m_block.clear();
+    }
+
+ public:
+    explicit gif_code_packer(std::ostream& stream) : m_stream(stream) { m_block.reserve(255); }
+
+    void write(std::uint32_t code, int code_size) {
+        m_bits |= code << m_nb_bits;
+        m_nb_bits += code_size;
+        while (m_nb_bits >= 8) {
+            m_block.push_back(static_cast<std::uint8_t>(m_bits & 0xFF));
+            m_bits >>= 8;
+            m_nb_bits -= 8;
+            if (m_block.size() == 255) {
+                flush_block();
+            }
+        }
+    }
+
+    void finish() {
+        if (m_nb_bits > 0) {
+            m_block.push_back(static_cast<std::uint8_t>(m_bits & 0xFF));
+            m_bits    = 0;
+            m_nb_bits = 0;
+        }
+        if (!m_block.empty()) {
+            flush_block();
+        }
+        m_stream.put(0);
+    }
+};
+
+}  // namespace
+
+/**
+ * @brief Convert a format name (csv, ppm, png, gif, trajectory) to a frame_format.
+ *
+ * @param name
+ * @return frame_format
+ */
+frame_format parse_frame_format(const std::string& name) {
+    if (name == "csv") {
+        return frame_format::csv;
+    }
+    if (name == "ppm") {
+        return frame_format::ppm;
+    }
+    if (name == "png") {
+        return frame_format::png;
+    }
+    if (name == "gif") {
+        return frame_format::gif;
+    }
+    if (name == "trajectory") {
+        return frame_format::trajectory;
+    }
+    throw std::invalid_argument("Unknown frame format: " + name + " (expected csv, ppm, png, gif or trajectory)");
+}
+
+/**
+ * @brief Construct a new frame renderer::frame renderer object.
+ *
+ * @param width Width of the field (number of sites along x).
+ * @param height Height of the field (number of sites along y).
+ * @param options
+ */
+frame_renderer::frame_renderer(std::size_t width, std::size_t height, const frame_export_options& options)
+    : m_width(width),
+      m_height(height),
+      m_image_width(width),
+      m_image_height(height) {
+    if (options.target_width > 0 && options.target_width < m_width) {
+        m_image_width = options.target_width;
+        m_image_height =
+            std::max<std::size_t>(1, static_cast<std::size_t>(std::lround(static_cast<double>(height) * m_image_width / width)));
+    }
+    if (options.target_height > 0 && options.target_height < m_height) {
+        m_image_height = options.target_height;
+    }
+    m_image_height = std::min(m_image_height, m_height);
+
+    for (std::size_t index = 0; index < 256; index++) {
+        const double    t    = index / 255.0;
+        const rgb_color low  = t < 0.5 ? options.color_down : options.color_middle;
+        const rgb_color high = t < 0.5 ? options.color_middle : options.color_up;
+        const double    u    = t < 0.5 ? 2.0 * t : 2.0 * t - 1.0;
+        m_palette[index]     = {static_cast<std::uint8_t>(std::lround(low.r + u * (high.r - low.r))),
+                                static_cast<std::uint8_t>(std::lround(low.g + u * (high.g - low.g))),
+                                static_cast<std::uint8_t>(std::lround(low.b + u * (high.b - low.b)))};
+    }
+
+    m_column_bounds.resize(m_image_width + 1);
+    m_row_bounds.resize(m_image_height + 1);
+    for (std::size_t i = 0; i <= m_image_width; i++) {
+        m_column_bounds[i] = i * m_width / m_image_width;
+    }
+    for (std::size_t j = 0; j <= m_image_height; j++) {
+        m_row_bounds[j] = j * m_height / m_image_height;
+    }
+    m_row_sums.resize(m_image_width);
+    m_indices.resize(m_image_width * m_image_height);
+}
+
+/**
+ * @brief Average the field over the pixel boxes and map the values to palette indices.
+ *
+ * The field rows are read sequentially, each box average being accumulated row by row.
+ *
+ * @param field
+ * @return const std::vector<std::uint8_t>& Palette indices of the image, row-major.
+ */
+const std::vector<std::uint8_t>& frame_renderer::render(const double* field) {
+    for (std::size_t j = 0; j < m_image_height; j++) {
+        std::fill(m_row_sums.begin(), m_row_sums.end(), 0.0);
+        for (std::size_t y = m_row_bounds[j]; y < m_row_bounds[j + 1]; y++) {
+            const double* row = field + y * m_width;
+            for (std::size_t i = 0; i < m_image_width; i++) {
+                double sum = 0.0;
+                for (std::size_t x = m_column_bounds[i]; x < m_column_bounds[i + 1]; x++) {
+                    sum += row[x];
+                }
+                m_row_sums[i] += sum;
+            }
+        }
+        const std::size_t box_height = m_row_bounds[j + 1] - m_row_bounds[j];
+        for (std::size_t i = 0; i < m_image_width; i++) {
+            const double box_size = static_cast<double>(box_height * (m_column_bounds[i + 1] - m_column_bounds[i]));
+            const double value    = std::clamp(m_row_sums[i] / box_size, -1.0, 1.0);
+            m_indices[i + j * m_image_width] = static_cast<std::uint8_t>(std::lround((value + 1.0) * 127.5));
+        }
+    }
+    return m_indices;
+}
+
+/**
+ * @brief Write the field as a binary PPM (P6) image.
+ *
+ * @param filename
+ * @param field
+ */
+void frame_renderer::write_ppm(const std::string& filename, const double* field) {
+    const std::vector<std::uint8_t>& indices = render(field);
+    std::string                      pixels(3 * indices.size(), '\0');
+    for (std::size_t index = 0; index < indices.size(); index++) {
+        const rgb_color& color   = m_palette[indices[index]];
+        pixels[3 * index]     = static_cast<char>(color.r);
+        pixels[3 * index + 1] = static_cast<char>(color.g);
+        pixels[3 * index + 2] = static_cast<char>(color.b);
+    }
+    std::ofstream file(filename, std::ios::binary);
+    file << "P6\n" << m_image_width << " " << m_image_height << "\n255\n";
+    file.write(pixels.data(), static_cast<std::streamsize>(pixels.size()));
+}
+
+/**
+ * @brief Write the field as an 8-bit indexed PNG image.
+ *
+ * The image data is stored in uncompressed deflate blocks: encoding is then a plain copy, which is what matters when
+ * thousands of frames are exported during a run.
+ *
+ * @param filename
+ * @param field
+ */
+void frame_renderer::write_png(const std::string& filename, const double* field) {
+    const std::vector<std::uint8_t>& indices = render(field);
+
+    std::string raw;
+    raw.reserve((m_image_width + 1) * m_image_height);
+    for (std::size_t j = 0; j < m_image_height; j++) {
+        raw.push_back('\0');
+        raw.append(reinterpret_cast<const char*>(indices.data() + j * m_image_width), m_image_width);
+    }
+
+    std::string   zlib_stream = {'\x78', '\x01'};
+    std::uint32_t adler_a     = 1;
+    std::uint32_t adler_b     = 0;
+    for (char byte : raw) {
+        adler_a = (adler_a + static_cast<std::uint8_t>(byte)) % 65521;
+        adler_b = (adler_b + adler_a) % 65521;
+    }
+    const std::size_t max_block = 65535;
+    std::size_t       offset    = 0;
+    do {
+        const std::size_t length = std::min(max_block, raw.size() - offset);
+        const bool        last   = offset + length == raw.size();
+        zlib_stream.push_back(last ? '\x01' : '\x00');
+        zlib_stream.push_back(static_cast<char>(length & 0xFF));
+        zlib_stream.push_back(static_cast<char>((length >> 8) & 0xFF));
+        zlib_stream.push_back(static_cast<char>(~length & 0xFF));
+        zlib_stream.push_back(static_cast<char>((~length >> 8) & 0xFF));
+        zlib_stream.append(raw, offset, length);
+        offset += length;
+    } while (offset < raw.size());
+    write_u32_big_endian(zlib_stream, (adler_b << 16) | adler_a);
+
+    std::string header;
+    write_u32_big_endian(header, static_cast<std::uint32_t>(m_image_width));
+    write_u32_big_endian(header, static_cast<std::uint32_t>(m_image_height));
+    header += {'\x08', '\x03', '\x00', '\x00', '\x00'};
+
+    std::string palette;
+    for (const rgb_color& color : m_palette) {
+        palette += {static_cast<char>(color.r), static_cast<char>(color.g), static_cast<char>(color.b)};
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write("\x89PNG\r\n\x1a\n", 8);
+    write_png_chunk(file, "IHDR", header);
+    write_png_chunk(file, "PLTE", palette);
+    write_png_chunk(file, "IDAT", zlib_stream);
+    write_png_chunk(file, "IEND", "");
+}
+
+/**
+ * @brief Construct a new gif writer::gif writer object and write the file header.
+ *
+ * @param filename
+ * @param width
+ * @param height
+ * @param palette
+ * @param delay Delay between frames, in hundredths of a second.
+ */
+gif_writer::gif_writer(const std::string&                filename,
+                       std::size_t                       width,
+                       std::size_t                       height,
+                       const std::array<rgb_color, 256>& palette,
+                       std::size_t                       delay)
+    : m_file(filename, std::ios::binary),
+      m_width(width),
+      m_height(height),
+      m_delay(delay),
+      m_dictionary(4096 * 256) {
+    m_file.write("GIF89a", 6);
+    write_u16_little_endian(m_file, m_width);
+    write_u16_little_endian(m_file, m_height);
+    m_file.put(static_cast<char>(0xF7));
+    m_file.put(0);
+    m_file.put(0);
+    for (const rgb_color& color : palette) {
+        m_file.put(static_cast<char>(color.r));
+        m_file.put(static_cast<char>(color.g));
+        m_file.put(static_cast<char>(color.b));
+    }
+    // NETSCAPE2.0 application extension: loop forever.
+    m_file.write("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+}
+
+gif_writer::~gif_writer() { m_file.put(0x3B); }
+
+/**
+ * @brief Append a frame (palette indices, row-major) to the animation.
+ *
+ * @param indices
+ */
+void gif_writer::add_frame(const std::vector<std::uint8_t>& indices) {
+    m_file.write("\x21\xF9\x04\x04", 4);
+    write_u16_little_endian(m_file, m_delay);
+    m_file.put(0);
+    m_file.put(0);
+
+    m_file.put(0x2C);
+    write_u16_little_endian(m_file, 0);
+    write_u16_little_endian(m_file, 0);
+    write_u16_little_endian(m_file, m_width);
+    write_u16_little_endian(m_file, m_height);
+    m_file.put(0);
+
+    const int           min_code_size = 8;
+    const std::uint32_t clear_code    = 1u << min_code_size;
+    m_file.put(static_cast<char>(min_code_size));
+
+    gif_code_packer packer(m_file);
+    int             code_size = min_code_size + 1;
+    std::uint32_t   max_code  = clear_code + 1;
+    std::fill(m_dictionary.begin(), m_dictionary.end(), 0);
+    packer.write(clear_code, code_size);
+
+    std::uint32_t current_code = indices.empty() ? 0 : indices[0];
+    for (std::size_t index = 1; index < indices.size(); index++) {
+        const std::uint8_t pixel = indices[index];
+        std::uint16_t&     child = m_dictionary[current_code * 256 + pixel];
+        if (child != 0) {
+            current_code = child;
+            continue;
+        }
+        packer.write(current_code, code_size);
+        child = static_cast<std::uint16_t>(++max_code);
+        if (max_code >= (1u << code_size)) {
+            code_size++;
+        }
+        if (max_code == 4095) {
+            packer.write(clear_code, code_size);
+            std::fill(m_dictionary.begin(), m_dictionary.end(), 0);
+            code_size = min_code_size + 1;
+            max_code  = clear_code + 1;
+        }
+        current_code = pixel;
+    }
+    packer.write(current_code, code_size);
+    packer.write(clear_code, code_size);
+    packer.write(clear_code + 1, min_code_size + 1);
+    packer.finish();
+}
+
+/**
+ * @brief Construct a new frame exporter::frame exporter object.
+ *
+ * @param filename Prefix of the exported files.
+ * @param width
+ * @param height
+ * @param options
+ */
+frame_exporter::frame_exporter(const std::string& filename, std::size_t width, std::size_t height, const frame_export_options& options)
+    : m_filename(filename),
+      m_options(options),
+      m_renderer(width, height, options) {
+    if (m_options.format == frame_format::gif) {
+        m_gif = std::make_unique<gif_writer>(m_filename + ".gif", m_renderer.get_image_width(), m_renderer.get_image_height(),
+                                             m_renderer.get_palette(), m_options.gif_delay);
+    }
+}
+
+/**
+ * @brief Write one frame: an individual image file (filename_XXXXX.ext) or a new frame of the GIF animation.
+ *
+ * @param field
+ * @param index_frame
+ */
+void frame_exporter::write_frame(const double* field, std::size_t index_frame) {
+    std::ostringstream ss;
+    ss << m_filename << "_" << std::setw(5) << std::setfill('0') << index_frame;
+    switch (m_options.format) {
+        case frame_format::ppm:
+            m_renderer.write_ppm(ss.str() + ".ppm", field);
+            break;
+        case frame_format::png:
+            m_renderer.write_png(ss.str() + ".png", field);
+            break;
+        case frame_format::gif:
+            m_gif->add_frame(m_renderer.render(field));
+            break;
+        case frame_format::csv:
+            throw std::invalid_argument("CSV frames are written by export_to_file");
+        case frame_format::trajectory:
+            throw std::invalid_argument("Trajectories are written by the trajectory recorder");
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file frame_renderer.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief In-process rendering of spin configurations to PPM, PNG and animated GIF images.
+ * @version 0.1
+ * @date 2022-09-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Output of the configurations: one CSV file or image per exported iteration, a GIF animation, or a trajectory
+ * file of the flips (see trajectory_recorder), the stride being then the interval between keyframes.
+ */
+enum class frame_format { csv, ppm, png, gif, trajectory };
+
+/**
+ * @brief How a 3D lattice is reduced to a 2D image: a single z slice or the mean over z.
+ */
+enum class frame_mode_3d { slice, projection };
+
+frame_format parse_frame_format(const std::string& name);
+
+struct rgb_color {
+    std::uint8_t r;
+    std::uint8_t g;
+    std::uint8_t b;
+};
+
+struct frame_export_options {
+    frame_format  format        = frame_format::csv;
+    std::size_t   stride        = 1;
+    std::size_t   target_width  = 0;
+    std::size_t   target_height = 0;
+    rgb_color     color_down    = {13, 8, 135};
+    rgb_color     color_middle  = {204, 71, 120};
+    rgb_color     color_up      = {240, 249, 33};
+    frame_mode_3d mode_3d       = frame_mode_3d::slice;
+    std::size_t   slice_index   = 0;
+    std::size_t   gif_delay     = 4;
+};
+
+/**
+ * @brief Map a scalar field in [-1, 1] (x is the fastest axis) to a 256-color palette, with optional box downsampling.
+ *
+ * The target resolution is only used to reduce the image: when it is 0 or larger than the field, the native
+ * resolution is kept. If only the width is given, the height follows the aspect ratio of the field.
+ */
+class frame_renderer {
+ private:
+    std::size_t m_width;
+    std::size_t m_height;
+    std::size_t m_image_width;
+    std::size_t m_image_height;
+
+    std::array<rgb_color, 256> m_palette;
+    std::vector<std::size_t>   m_column_bounds;
+    std::vector<std::size_t>   m_row_bounds;
+    std::vector<double>        m_row_sums;
+    std::vector<std::uint8_t>  m_indices;
+
+ public:
+    frame_renderer(std::size_t width, std::size_t height, const frame_export_options& options);
+
+    std::size_t                       get_image_width() const { return m_image_width; }
+    std::size_t                       get_image_height() const { return m_image_height; }
+    const std::array<rgb_color, 256>& get_palette() const { return m_palette; }
+
+    const std::vector<std::uint8_t>& render(const double* field);
+
+    void write_ppm(const std::string& filename, const double* field);
+    void write_png(const std::string& filename, const double* field);
+};
+
+/**
+ * @brief Minimal animated GIF encoder (global 256-color palette, LZW compression, infinite loop).
+ *
+ */
+class gif_writer {
+ private:
+    std::ofstream              m_file;
+    std::size_t                m_width;
+    std::size_t                m_height;
+    std::size_t                m_delay;
+    std::vector<std::uint16_t> m_dictionary;
+
+ public:
+    gif_writer(const std::string& filename, std::size_t width, std::size_t height, const std::array<rgb_color, 256>& palette,
+               std::size_t delay);
+    ~gif_writer();
+
+    void add_frame(const std::vector<std::uint8_t>& indices);
+};
+
+/**
+ * @brief Write the frames of a simulation with a given export format, following the naming of the CSV exports.
+ *
+ */
+class frame_exporter {
+ private:
+    std::string                 m_filename;
+    frame_export_options        m_options;
+    frame_renderer              m_renderer;
+    std::unique_ptr<gif_writer> m_gif;
+
+ public:
+    frame_exporter(const std::string& filename, std::size_t width, std::size_t height, const frame_export_options& options);
+
+    void write_frame(const double* field, std::size_t index_frame);
+};
@@ -0,0 +1,117 @@
+/**
+ * @file generator.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Minimal C++20 coroutine generator (a lazy input range of values).
+ * @version 0.1
+ * @date 2022-09-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Lazy sequence of values produced by a coroutine with co_yield.
+ *
+ * The coroutine only runs when the consumer advances the iterator, and stops at each co_yield: nothing is computed
+ * ahead of the consumer and nothing is buffered. The yielded value is referenced, not copied, and stays valid until the
+ * iterator is advanced. Destroying the generator before the end cancels the rest of the sequence. An exception thrown
+ * by the coroutine is rethrown to the consumer.
+ *
+ * @tparam T
+ */
+template <typename T>
+class generator {
+ public:
+    struct promise_type {
+        const T*           m_value = nullptr;
+        std::exception_ptr m_exception;
+
+        generator get_return_object() { return generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const T& value) noexcept {
+            m_value = std::addressof(value);
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { m_exception = std::current_exception(); }
+
+        // A generator only yields, it cannot await.
+        template <typename U>
+        std::suspend_never await_transform(U&&) = delete;
+    };
+
+    class iterator {
+     private:
+        std::coroutine_handle<promise_type> m_handle;
+
+     public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = T;
+
+        iterator() = default;
+        explicit iterator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        const T& operator*() const { return *m_handle.promise().m_value; }
+        const T* operator->() const { return m_handle.promise().m_value; }
+
+        iterator& operator++() {
+            m_handle.resume();
+            if (m_handle.done() && m_handle.promise().m_exception) {
+                std::rethrow_exception(m_handle.promise().m_exception);
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) { return !it.m_handle || it.m_handle.done(); }
+    };
+
+ private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit generator(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+ public:
+    generator(const generator&)            = delete;
+    generator& operator=(const generator&) = delete;
+    generator(generator&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    generator& operator=(generator&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    ~generator() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    /**
+     * @brief Start the coroutine and run it up to its first value.
+     *
+     * As for any input range, begin() must only be called once.
+     */
+    iterator begin() {
+        iterator it(m_handle);
+        if (m_handle) {
+            ++it;
+        }
+        return it;
+    }
+    std::default_sentinel_t end() const noexcept { return {}; }
+};
@@ -18,7 +18,12 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "correlation.hpp"
 
 /**
  * @brief Construct a new ising 2d::ising 2d object.
@@ -32,6 +37,33 @@ ising_2d::ising_2d(std::size_t size_x, std::size_t size_y, double temperature)
       m_size_x(size_x),
       m_size_y(size_y) {
     m_spins.resize(m_size_x * m_size_y);
+    first_touch(nullptr);
+}
+
+/**
+ * @brief Write the spins (all up, or a copy of spins) with the same static row decomposition as
+ * metropolis_step_parallel(m_number_threads).
+ *
+ * The spin array is allocated without being written, so this first write decides where its pages live: each pair of
+ * rows lands on the NUMA node of the thread which later updates it. Inside an enclosing parallel region (one lattice
+ * per thread), the region is nested and the calling thread, which also sweeps the lattice, writes all the rows.
+ *
+ * @param spins Spins to copy, nullptr for all up.
+ */
+void ising_2d::first_touch(const double* spins) {
+    auto write_rows = [&](std::size_t first_row, std::size_t last_row) {
+        if (spins != nullptr) {
+            std::copy(spins + first_row * m_size_x, spins + last_row * m_size_x, m_spins.begin() + first_row * m_size_x);
+        } else {
+            std::fill(m_spins.begin() + first_row * m_size_x, m_spins.begin() + last_row * m_size_x, 1.0);
+        }
+    };
+    const std::size_t nb_pairs = m_size_y / 2;
+#pragma omp parallel for schedule(static) num_threads(m_number_threads)
+    for (std::size_t pair = 0; pair < nb_pairs; pair++) {
+        write_rows(2 * pair, 2 * pair + 2);
+    }
+    write_rows(2 * nb_pairs, m_size_y);
 }
 
 /**
@@ -66,11 +98,13 @@ double ising_2d::get_spin(std::size_t x, std::size_t y) const { return m_spins[x
  * @param y
  * @param value
  */
-void ising_2d::set_spin(std::size_t x, std::size_t y, double value) { m_spins[x + y * m_size_x] = value; }
+void ising_2d::set_spin(std::size_t x, std::size_t y, double value) { set_spin_at(x + y * m_size_x, value); }
 
 /**
  * @brief Compute the energy of the spin at position (x, y).
  *
+ * The long-range interaction, when enabled, adds -s h to the nearest-neighbor energy, h being its local field.
+ *
  * @param x
  * @param y
  * @return double
@@ -82,7 +116,7 @@ double ising_2d::compute_energy(std::size_t x, std::size_t y) const {
         energy += -get_spin(neighbor.first, neighbor.second) * get_spin(x, y) * (neighbor.first != x ? m_x_anisotropic_factor : 1.0) *
                   (neighbor.second != y ? m_y_anisotropic_factor : 1.0);
     }
-    return energy;
+    return energy + compute_long_range_energy(x + y * m_size_x);
 }
 
 /**
@@ -127,82 +161,171 @@ double ising_2d::compute_susceptibility() const {
     return magnetization * magnetization / (m_size_x * m_size_y);
 }
 
+/**
+ * @brief Compute the energy variation if the spin at the linear index is flipped.
+ *
+ * @param index
+ * @return double
+ */
+double ising_2d::compute_flip_delta_energy(std::size_t index) const { return -2 * compute_energy(index % m_size_x, index / m_size_x); }
+
+/**
+ * @brief Metropolis flip attempt of the spin at position (x, y).
+ *
+ * @param x
+ * @param y
+ * @param random_engine
+ * @param double_distribution
+ * @return true if the spin was flipped.
+ */
+inline bool ising_2d::metropolis_attempt(std::size_t                       x,
+                                         std::size_t                       y,
+                                         std::mt19937&                     random_engine,
+                                         std::uniform_real_distribution<>& double_distribution) {
+    double delta_energy = -2 * compute_energy(x, y);
+    if (delta_energy <= 0.0 || double_distribution(random_engine) < std::exp(-delta_energy / m_temperature)) {
+        flip_spin_at(x + y * m_size_x);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief One Metropolis sweep: exactly size_x * size_y flip attempts, in the order given by m_sweep_order, or the
+ * parallel sweep when more than one thread is set (set_number_threads()).
+ *
+ */
 void ising_2d::metropolis_step() {
+    if (m_number_threads > 1) {
+        metropolis_step_parallel(m_number_threads);
+        return;
+    }
     m_number_modified_spins = 0;
-    std::uniform_real_distribution<>           double_distribution(0.0, 1.0);
-    std::uniform_int_distribution<std::size_t> int_distribution(0, m_size_y - 1);
-    for (std::size_t idx_x = 0; idx_x < m_size_x; idx_x++) {
-        for (std::size_t idx_y = 0; idx_y < m_size_y; idx_y++) {
-            std::size_t x            = int_distribution(m_random_engine);
-            std::size_t y            = int_distribution(m_random_engine);
-            double      delta_energy = -2 * compute_energy(x, y);
-            if (delta_energy <= 0.0) {
-                set_spin(x, y, -get_spin(x, y));
-                m_number_modified_spins++;
-            } else {
-                if (double_distribution(m_random_engine) < std::exp(-delta_energy / m_temperature)) {
-                    set_spin(x, y, -get_spin(x, y));
-                    m_number_modified_spins++;
-                }
+    std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+    switch (m_sweep_order) {
+        case sweep_order::random: {
+            std::uniform_int_distribution<std::size_t> int_distribution_x(0, m_size_x - 1);
+            std::uniform_int_distribution<std::size_t> int_distribution_y(0, m_size_y - 1);
+            for (std::size_t index_attempt = 0; index_attempt < m_size_x * m_size_y; index_attempt++) {
+                std::size_t x = int_distribution_x(m_random_engine);
+                std::size_t y = int_distribution_y(m_random_engine);
+                m_number_modified_spins += metropolis_attempt(x, y, m_random_engine, double_distribution);
             }
+            break;
         }
+        case sweep_order::sequential:
+            for (std::size_t y = 0; y < m_size_y; y++) {
+                for (std::size_t x = 0; x < m_size_x; x++) {
+                    m_number_modified_spins += metropolis_attempt(x, y, m_random_engine, double_distribution);
+                }
+            }
+            break;
+        case sweep_order::strided:
+            for (std::size_t parity = 0; parity < 2; parity++) {
+                for (std::size_t y = parity; y < m_size_y; y += 2) {
+                    for (std::size_t x = 0; x < m_size_x; x++) {
+                        m_number_modified_spins += metropolis_attempt(x, y, m_random_engine, double_distribution);
+                    }
+                }
+            }
+            break;
     }
+    record_trajectory_sweep();
 }
 
-void ising_2d::metropolis_step_parallel(int num_treads) {
-    std::uniform_real_distribution<>           double_distribution(0.0, 1.0);
-    std::uniform_int_distribution<std::size_t> int_distribution(0, m_size_y - 1);
-#pragma omp parallel for
-    for (std::size_t idx_x = 0; idx_x < m_size_x; idx_x++) {
-        for (std::size_t idx_y = 0; idx_y < m_size_y; idx_y++) {
-            std::size_t x            = int_distribution(m_random_engine);
-            std::size_t y            = int_distribution(m_random_engine);
-            double      delta_energy = -2 * compute_energy(x, y);
-#pragma omp critical
-            if (delta_energy <= 0.0) {
-                set_spin(x, y, -get_spin(x, y));
-            } else {
-                if (double_distribution(m_random_engine) < std::exp(-delta_energy / m_temperature)) {
-                    set_spin(x, y, -get_spin(x, y));
-                }
+/**
+ * @brief One Metropolis sweep (exactly size_x * size_y attempts) distributed over nb_threads OpenMP threads.
+ *
+ * The sweep follows the strided order: all the even rows, then all the odd rows. Rows of the same parity do not
+ * interact, so they are updated concurrently, each pair of rows (2k, 2k + 1) being owned by the same thread (static
+ * schedule, as in first_touch()). Each thread draws from its own random engine. With an odd number of rows, the last
+ * row is updated after the two passes.
+ *
+ * @param nb_threads
+ */
+void ising_2d::metropolis_step_parallel(int nb_threads) {
+    if (m_long_range) {
+        throw std::logic_error("The parallel sweep is not available with long-range interactions.");
+    }
+    prepare_thread_engines(static_cast<std::size_t>(std::max(nb_threads, 1)));
+    const std::size_t nb_pairs    = m_size_y / 2;
+    std::size_t       nb_modified = 0;
+    for (std::size_t parity = 0; parity < 2; parity++) {
+#pragma omp parallel for schedule(static) num_threads(nb_threads) reduction(+ : nb_modified)
+        for (std::size_t pair = 0; pair < nb_pairs; pair++) {
+            std::mt19937&                    random_engine = m_thread_engines[thread_index()];
+            std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+            const std::size_t                y = 2 * pair + parity;
+            for (std::size_t x = 0; x < m_size_x; x++) {
+                nb_modified += metropolis_attempt(x, y, random_engine, double_distribution);
             }
         }
     }
+    std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+    for (std::size_t y = 2 * nb_pairs; y < m_size_y; y++) {
+        for (std::size_t x = 0; x < m_size_x; x++) {
+            nb_modified += metropolis_attempt(x, y, m_random_engine, double_distribution);
+        }
+    }
+    m_number_modified_spins = nb_modified;
+    record_trajectory_sweep();
 }
 
 ising_result ising_2d::metropolis_simulation(std::size_t nb_steps, const double convergence_threshold) {
-    double energy = compute_total_energy();
-
-    for (std::size_t index_simulation = 0; index_simulation < nb_steps; index_simulation++) {
-        metropolis_step();
-        m_number_iterations++;
-        double       ratio_modified_spins = static_cast<double>(m_number_modified_spins) / (m_size_x * m_size_y);
-        double       new_energy           = compute_total_energy();
-        ising_result result{compute_total_energy(), compute_total_magnetization(), compute_specific_heat(), compute_susceptibility()};
-        if (ratio_modified_spins < convergence_threshold || (std::abs((new_energy - energy) / energy)) < convergence_threshold) {
-            return result;
-        }
-        energy = new_energy;
+    double             energy = compute_total_energy();
+    simulation_options options;
+    options.stop_condition = [&energy, convergence_threshold](const sweep_record& record) {
+        const bool converged =
+            record.acceptance < convergence_threshold || (std::abs((record.energy - energy) / energy)) < convergence_threshold;
+        energy = record.energy;
+        return converged;
+    };
+    for ([[maybe_unused]] const sweep_record& record : simulate(nb_steps, options)) {
     }
     ising_result result{compute_total_energy(), compute_total_magnetization(), compute_specific_heat(), compute_susceptibility()};
     return result;
 }
 
+/**
+ * @brief Run the simulation and export the observables and the configurations.
+ *
+ * A configuration is exported every m_frame_export.stride iterations, either as a CSV file or rendered
+ * as an image (see set_frame_export()). With the trajectory format, every sweep is recorded to filename.trajectory
+ * instead, with a keyframe every m_frame_export.stride sweeps.
+ *
+ * @param nb_steps
+ * @param filename
+ */
 void ising_2d::metropolis_simulation_with_export(std::size_t nb_steps, const std::string& filename) {
     std::ofstream file(filename + ".csv");
     file << "temperature,total_energy,total_magnetization,specific_heat,susceptibility" << std::endl;
-    for (std::size_t index_simulation = 0; index_simulation < nb_steps; index_simulation++) {
-        metropolis_step();
-
-        std::ostringstream ss;
-        ss << std::setw(5) << std::setfill('0') << index_simulation;
-        std::string       str_index_simulation = ss.str();
-        const std::string filename_iter        = filename + "_" + str_index_simulation + ".csv";
-        export_to_file(filename_iter);
-        file << m_temperature << "," << compute_total_energy() << "," << compute_total_magnetization() << "," << compute_specific_heat()
-             << "," << compute_susceptibility() << std::endl;
-        std::cout << "\r Iteration " << index_simulation << " / " << nb_steps << " (" << (index_simulation * 100.0 / nb_steps) << "%)"
-                  << std::flush;
+    std::unique_ptr<frame_exporter> exporter;
+    const std::size_t               stride     = std::max<std::size_t>(1, m_frame_export.stride);
+    const bool                      trajectory = m_frame_export.format == frame_format::trajectory;
+    if (trajectory) {
+        start_trajectory_recording(filename + ".trajectory", stride);
+    } else if (m_frame_export.format != frame_format::csv) {
+        exporter = std::make_unique<frame_exporter>(filename, m_size_x, m_size_y, m_frame_export);
+    }
+    simulation_options options;
+    options.on_progress = console_progress(nb_steps);
+    for (const sweep_record& record : simulate(nb_steps, options)) {
+        if (!trajectory && record.sweep % stride == 0) {
+            if (exporter) {
+                exporter->write_frame(m_spins.data(), record.sweep);
+            } else {
+                std::ostringstream ss;
+                ss << std::setw(5) << std::setfill('0') << record.sweep;
+                std::string       str_index_simulation = ss.str();
+                const std::string filename_iter        = filename + "_" + str_index_simulation + ".csv";
+                export_to_file(filename_iter);
+            }
+        }
+        file << m_temperature << "," << record.energy << "," << record.magnetization << "," << compute_specific_heat() << ","
+             << compute_susceptibility() << std::endl;
+    }
+    if (trajectory) {
+        stop_trajectory_recording();
     }
 }
 
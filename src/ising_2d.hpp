@@ -29,6 +29,9 @@ class ising_2d : public ising_base {
     double m_x_anisotropic_factor = 1.0;
     double m_y_anisotropic_factor = 1.0;
 
+    bool metropolis_attempt(std::size_t x, std::size_t y, std::mt19937& random_engine, std::uniform_real_distribution<>& double_distribution);
+    void first_touch(const double* spins) override;
+
  public:
     ising_2d(std::size_t size_x, std::size_t size_y, double temperature = 1.0);
 
@@ -44,9 +47,14 @@ class ising_2d : public ising_base {
     double compute_total_magnetization() const;
     double compute_specific_heat() const;
     double compute_susceptibility() const;
+    double compute_flip_delta_energy(std::size_t index) const override;
+
+    std::array<std::size_t, 3>              get_shape() const override { return {m_size_x, m_size_y, 1}; }
+    std::vector<std::array<std::size_t, 3>> get_bond_displacements() const override { return {{1, 0, 0}, {0, 1, 0}}; }
+    std::unique_ptr<ising_base>             clone() const override { return std::make_unique<ising_2d>(*this); }
 
-    void metropolis_step();
-    void metropolis_step_parallel(int num_treads);
+    void metropolis_step() override;
+    void metropolis_step_parallel(int nb_threads);
 
     ising_result metropolis_simulation(std::size_t nb_steps, const double convergence_threshold);
     void         metropolis_simulation_with_export(std::size_t nb_steps, const std::string& filename);
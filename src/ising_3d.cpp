@@ -18,7 +18,12 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "correlation.hpp"
 
 #include "ising_3d.hpp"
 #include "ising_base.hpp"
@@ -26,17 +31,83 @@
 /**
  * @brief Construct a new ising 2d::ising 2d object.
  *
+ * With a storage directory, the spins live in a memory-mapped file of that directory instead of memory (see
+ * ising_base::set_spin_storage()), so that the lattice can be larger than the RAM.
+ *
  * @param size_x
  * @param size_y
  * @param size_z
  * @param temperature
+ * @param storage_directory
  */
-ising_3d::ising_3d(std::size_t size_x, std::size_t size_y, std::size_t size_z, double temperature)
+ising_3d::ising_3d(std::size_t size_x, std::size_t size_y, std::size_t size_z, double temperature, const std::string& storage_directory)
     : ising_base(temperature),
       m_size_x(size_x),
       m_size_y(size_y),
       m_size_z(size_z) {
+    m_spins = spin_vector(spin_allocator<double>(storage_directory));
     m_spins.resize(m_size_x * m_size_y * m_size_z);
+    if (is_file_backed()) {
+        m_sweep_order = sweep_order::sequential;
+    }
+    first_touch(nullptr);
+}
+
+/**
+ * @brief Write the spins (all up, or a copy of spins) with the same static plane decomposition as
+ * metropolis_step_parallel(m_number_threads).
+ *
+ * The spin array is allocated without being written, so this first write decides where its pages live: each pair of
+ * z planes lands on the NUMA node of the thread which later updates it. Inside an enclosing parallel region (one
+ * lattice per thread), the region is nested and the calling thread, which also sweeps the lattice, writes all the
+ * planes. A file-backed array is written back pair by pair, so that its initialization does not fill the memory.
+ *
+ * @param spins Spins to copy, nullptr for all up.
+ */
+void ising_3d::first_touch(const double* spins) {
+    const std::size_t plane_size   = m_size_x * m_size_y;
+    auto              write_planes = [&](std::size_t first_plane, std::size_t last_plane) {
+        if (spins != nullptr) {
+            std::copy(spins + first_plane * plane_size, spins + last_plane * plane_size, m_spins.begin() + first_plane * plane_size);
+        } else {
+            std::fill(m_spins.begin() + first_plane * plane_size, m_spins.begin() + last_plane * plane_size, 1.0);
+        }
+        write_back_planes(first_plane, last_plane - first_plane);
+    };
+    const std::size_t nb_pairs = m_size_z / 2;
+#pragma omp parallel for schedule(static) num_threads(m_number_threads)
+    for (std::size_t pair = 0; pair < nb_pairs; pair++) {
+        write_planes(2 * pair, 2 * pair + 2);
+    }
+    write_planes(2 * nb_pairs, m_size_z);
+}
+
+/**
+ * @brief Slab hooks of the sweeps over a file-backed lattice (no-ops when the spins are in memory).
+ *
+ * The sweeps in z order call prefetch_planes() on the planes of their next step, so that the kernel reads them while
+ * the current plane is updated, and write_back_planes() on the planes they will not visit again in the pass. Only a
+ * handful of planes are then resident at any time, and a sweep runs at about the bandwidth of the disk. The planes z = 0
+ * and z = size_z - 1, neighbors of each other through the periodic boundary, are released at the end of each pass.
+ * Planes out of [0, size_z) are ignored.
+ *
+ * @param z First plane.
+ * @param nb_planes
+ */
+void ising_3d::prefetch_planes(std::size_t z, std::size_t nb_planes) const {
+    if (!is_file_backed() || z >= m_size_z) {
+        return;
+    }
+    const std::size_t plane_size = m_size_x * m_size_y;
+    spin_memory::prefetch(m_spins.data() + z * plane_size, std::min(nb_planes, m_size_z - z) * plane_size * sizeof(double));
+}
+
+void ising_3d::write_back_planes(std::size_t z, std::size_t nb_planes) const {
+    if (!is_file_backed() || z >= m_size_z) {
+        return;
+    }
+    const std::size_t plane_size = m_size_x * m_size_y;
+    spin_memory::write_back(m_spins.data() + z * plane_size, std::min(nb_planes, m_size_z - z) * plane_size * sizeof(double));
 }
 
 /**
@@ -77,12 +148,14 @@ double ising_3d::get_spin(std::size_t x, std::size_t y, std::size_t z) const { r
  * @param value
  */
 void ising_3d::set_spin(std::size_t x, std::size_t y, std::size_t z, double value) {
-    m_spins[x + y * m_size_x + z * m_size_x * m_size_y] = value;
+    set_spin_at(x + y * m_size_x + z * m_size_x * m_size_y, value);
 }
 
 /**
  * @brief Compute the energy of the spin at position (x, y).
  *
+ * The long-range interaction, when enabled, adds -s h to the nearest-neighbor energy, h being its local field.
+ *
  * @param x
  * @param y
  * @return double
@@ -94,7 +167,7 @@ double ising_3d::compute_energy(std::size_t x, std::size_t y, std::size_t z) con
         energy += -get_spin(neighbor[0], neighbor[1], neighbor[2]) * get_spin(x, y, z) * (neighbor[0] != x ? m_x_anisotropic_factor : 1.0) *
                   (neighbor[1] != y ? m_y_anisotropic_factor : 1.0) * (neighbor[2] != z ? m_z_anisotropic_factor : 1.0);
     }
-    return energy;
+    return energy + compute_long_range_energy(x + y * m_size_x + z * m_size_x * m_size_y);
 }
 
 /**
@@ -103,10 +176,11 @@ double ising_3d::compute_energy(std::size_t x, std::size_t y, std::size_t z) con
  * @return double
  */
 double ising_3d::compute_total_energy() const {
+    // Memory order (z outermost), so that a file-backed lattice is read sequentially.
     double energy = 0.0;
-    for (std::size_t x = 0; x < m_size_x; x++) {
+    for (std::size_t z = 0; z < m_size_z; z++) {
         for (std::size_t y = 0; y < m_size_y; y++) {
-            for (std::size_t z = 0; z < m_size_z; z++) {
+            for (std::size_t x = 0; x < m_size_x; x++) {
                 energy += compute_energy(x, y, z);
             }
         }
@@ -134,54 +208,236 @@ double ising_3d::compute_susceptibility() const {
     return magnetization * magnetization / (m_size_x * m_size_y * m_size_z);
 }
 
+/**
+ * @brief Compute the energy variation if the spin at the linear index is flipped.
+ *
+ * @param index
+ * @return double
+ */
+double ising_3d::compute_flip_delta_energy(std::size_t index) const {
+    const std::size_t x = index % m_size_x;
+    const std::size_t y = (index / m_size_x) % m_size_y;
+    const std::size_t z = index / (m_size_x * m_size_y);
+    return -2 * compute_energy(x, y, z);
+}
+
+/**
+ * @brief Metropolis flip attempt of the spin at position (x, y, z).
+ *
+ * @param x
+ * @param y
+ * @param z
+ * @param random_engine
+ * @param double_distribution
+ * @return true if the spin was flipped.
+ */
+inline bool ising_3d::metropolis_attempt(std::size_t                       x,
+                                         std::size_t                       y,
+                                         std::size_t                       z,
+                                         std::mt19937&                     random_engine,
+                                         std::uniform_real_distribution<>& double_distribution) {
+    double delta_energy = -2 * compute_energy(x, y, z);
+    if (delta_energy <= 0.0 || double_distribution(random_engine) < std::exp(-delta_energy / m_temperature)) {
+        flip_spin_at(x + y * m_size_x + z * m_size_x * m_size_y);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief One Metropolis sweep: exactly size_x * size_y * size_z flip attempts, in the order given by m_sweep_order, or
+ * the parallel sweep when more than one thread is set (set_number_threads()).
+ *
+ */
 void ising_3d::metropolis_step() {
-    std::uniform_real_distribution<>           double_distribution(0.0, 1.0);
-    std::uniform_int_distribution<std::size_t> int_distribution_x(0, m_size_x - 1);
-    std::uniform_int_distribution<std::size_t> int_distribution_y(0, m_size_y - 1);
-    std::uniform_int_distribution<std::size_t> int_distribution_z(0, m_size_z - 1);
-    for (std::size_t idx_x = 0; idx_x < m_size_x; idx_x++) {
-        for (std::size_t idx_y = 0; idx_y < m_size_y; idx_y++) {
-            std::size_t x            = int_distribution_x(m_random_engine);
-            std::size_t y            = int_distribution_y(m_random_engine);
-            std::size_t z            = int_distribution_z(m_random_engine);
-            double      delta_energy = -2 * compute_energy(x, y, z);
-            if (delta_energy <= 0.0) {
-                set_spin(x, y, z, -get_spin(x, y, z));
-            } else {
-                if (double_distribution(m_random_engine) < std::exp(-delta_energy / m_temperature)) {
-                    set_spin(x, y, z, -get_spin(x, y, z));
+    if (m_number_threads > 1) {
+        metropolis_step_parallel(m_number_threads);
+        return;
+    }
+    m_number_modified_spins = 0;
+    std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+    switch (m_sweep_order) {
+        case sweep_order::random: {
+            // No slab streaming: the random order touches the whole lattice at every sweep.
+            std::uniform_int_distribution<std::size_t> int_distribution_x(0, m_size_x - 1);
+            std::uniform_int_distribution<std::size_t> int_distribution_y(0, m_size_y - 1);
+            std::uniform_int_distribution<std::size_t> int_distribution_z(0, m_size_z - 1);
+            for (std::size_t index_attempt = 0; index_attempt < m_size_x * m_size_y * m_size_z; index_attempt++) {
+                std::size_t x = int_distribution_x(m_random_engine);
+                std::size_t y = int_distribution_y(m_random_engine);
+                std::size_t z = int_distribution_z(m_random_engine);
+                m_number_modified_spins += metropolis_attempt(x, y, z, m_random_engine, double_distribution);
+            }
+            break;
+        }
+        case sweep_order::sequential:
+            prefetch_planes(m_size_z - 1, 1);
+            prefetch_planes(0, 2);
+            for (std::size_t z = 0; z < m_size_z; z++) {
+                prefetch_planes(z + 2, 1);
+                for (std::size_t y = 0; y < m_size_y; y++) {
+                    for (std::size_t x = 0; x < m_size_x; x++) {
+                        m_number_modified_spins += metropolis_attempt(x, y, z, m_random_engine, double_distribution);
+                    }
+                }
+                if (z >= 2) {
+                    write_back_planes(z - 1, 1);
+                }
+            }
+            write_back_planes(0, 1);
+            write_back_planes(m_size_z - 2, 2);
+            break;
+        case sweep_order::strided:
+            // Each pass keeps about four planes resident: the one updated, its two neighbors and the next one.
+            for (std::size_t parity = 0; parity < 2; parity++) {
+                prefetch_planes(m_size_z - 1, 1);
+                prefetch_planes(0, parity + 2);
+                for (std::size_t z = parity; z < m_size_z; z += 2) {
+                    prefetch_planes(z + 2, 2);
+                    for (std::size_t y = 0; y < m_size_y; y++) {
+                        for (std::size_t x = 0; x < m_size_x; x++) {
+                            m_number_modified_spins += metropolis_attempt(x, y, z, m_random_engine, double_distribution);
+                        }
+                    }
+                    if (z >= 2) {
+                        write_back_planes(z - 1, 2);
+                    }
+                }
+                write_back_planes(0, 2);
+                write_back_planes(m_size_z - 1, 1);
+            }
+            break;
+    }
+    record_trajectory_sweep();
+}
+
+/**
+ * @brief One Metropolis sweep (exactly size_x * size_y * size_z attempts) distributed over nb_threads OpenMP threads.
+ *
+ * The sweep follows the strided order: all the even z planes, then all the odd ones. Planes of the same parity do not
+ * interact (the diagonal couplings are in-plane), so they are updated concurrently, each pair of planes being owned by
+ * the same thread (static schedule, as in first_touch()). With an odd number of planes, the last plane is updated
+ * after the two passes. On a file-backed lattice, each thread streams through its own range of planes with the slab
+ * hooks of the serial sweeps.
+ *
+ * @param nb_threads
+ */
+void ising_3d::metropolis_step_parallel(int nb_threads) {
+    if (m_long_range) {
+        throw std::logic_error("The parallel sweep is not available with long-range interactions.");
+    }
+    prepare_thread_engines(static_cast<std::size_t>(std::max(nb_threads, 1)));
+    const std::size_t nb_pairs    = m_size_z / 2;
+    std::size_t       nb_modified = 0;
+    for (std::size_t parity = 0; parity < 2; parity++) {
+#pragma omp parallel for schedule(static) num_threads(nb_threads) reduction(+ : nb_modified)
+        for (std::size_t pair = 0; pair < nb_pairs; pair++) {
+            std::mt19937&                    random_engine = m_thread_engines[thread_index()];
+            std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+            const std::size_t                z = 2 * pair + parity;
+            prefetch_planes(z + 2, 2);
+            for (std::size_t y = 0; y < m_size_y; y++) {
+                for (std::size_t x = 0; x < m_size_x; x++) {
+                    nb_modified += metropolis_attempt(x, y, z, random_engine, double_distribution);
                 }
             }
+            if (z >= 1) {
+                write_back_planes(z - 1, 2);
+            }
         }
     }
+    std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+    for (std::size_t z = 2 * nb_pairs; z < m_size_z; z++) {
+        for (std::size_t y = 0; y < m_size_y; y++) {
+            for (std::size_t x = 0; x < m_size_x; x++) {
+                nb_modified += metropolis_attempt(x, y, z, m_random_engine, double_distribution);
+            }
+        }
+    }
+    write_back_planes(0, 1);
+    write_back_planes(m_size_z - 2, 2);
+    m_number_modified_spins = nb_modified;
+    record_trajectory_sweep();
 }
 
 ising_result ising_3d::metropolis_simulation(std::size_t nb_steps, const double convergence_threshold) {
-    double energy = compute_total_energy();
-    for (std::size_t index_simulation = 0; index_simulation < nb_steps; index_simulation++) {
-        m_number_iterations++;
-        metropolis_step();
+    // No convergence criterion in 3D: run all the steps, the observables are only needed at the end.
+    simulation_options options;
+    options.record_stride = std::max<std::size_t>(1, nb_steps);
+    for ([[maybe_unused]] const sweep_record& record : simulate(nb_steps, options)) {
     }
     ising_result result{compute_total_energy(), compute_total_magnetization(), compute_specific_heat(), compute_susceptibility()};
     return result;
 }
 
+/**
+ * @brief Run the simulation and export the observables and the configurations.
+ *
+ * A configuration is exported every m_frame_export.stride iterations, either as a CSV file or rendered
+ * as an image (see set_frame_export()). With the trajectory format, every sweep is recorded to filename.trajectory
+ * instead, with a keyframe every m_frame_export.stride sweeps.
+ *
+ * @param nb_steps
+ * @param filename
+ */
 void ising_3d::metropolis_simulation_with_export(std::size_t nb_steps, const std::string& filename) {
     std::ofstream file(filename + ".csv");
     file << "temperature,total_energy,total_magnetization,specific_heat,susceptibility" << std::endl;
-    for (std::size_t index_simulation = 0; index_simulation < nb_steps; index_simulation++) {
-        metropolis_step();
+    std::unique_ptr<frame_exporter> exporter;
+    const std::size_t               stride     = std::max<std::size_t>(1, m_frame_export.stride);
+    const bool                      trajectory = m_frame_export.format == frame_format::trajectory;
+    if (trajectory) {
+        start_trajectory_recording(filename + ".trajectory", stride);
+    } else if (m_frame_export.format != frame_format::csv) {
+        exporter = std::make_unique<frame_exporter>(filename, m_size_x, m_size_y, m_frame_export);
+    }
+    simulation_options options;
+    options.on_progress = console_progress(nb_steps);
+    for (const sweep_record& record : simulate(nb_steps, options)) {
+        if (!trajectory && record.sweep % stride == 0) {
+            if (exporter) {
+                exporter->write_frame(compute_frame_field().data(), record.sweep);
+            } else {
+                std::ostringstream ss;
+                ss << std::setw(5) << std::setfill('0') << record.sweep;
+                std::string       str_index_simulation = ss.str();
+                const std::string filename_iter        = filename + "_" + str_index_simulation + ".csv";
+                export_to_file(filename_iter);
+            }
+        }
+        file << m_temperature << "," << record.energy << "," << record.magnetization / static_cast<double>(m_spins.size()) << ","
+             << compute_specific_heat() << "," << compute_susceptibility() << std::endl;
+    }
+    if (trajectory) {
+        stop_trajectory_recording();
+    }
+}
 
-        std::ostringstream ss;
-        ss << std::setw(5) << std::setfill('0') << index_simulation;
-        std::string       str_index_simulation = ss.str();
-        const std::string filename_iter        = filename + "_" + str_index_simulation + ".csv";
-        export_to_file(filename_iter);
-        file << m_temperature << "," << compute_total_energy() << "," << compute_total_magnetization() << "," << compute_specific_heat()
-             << "," << compute_susceptibility() << std::endl;
-        std::cout << "\r Iteration " << index_simulation << " / " << nb_steps << " (" << (index_simulation * 100.0 / nb_steps) << "%)"
-                  << std::flush;
+/**
+ * @brief Reduce the lattice to the 2D field rendered in the image frames.
+ *
+ * Depending on m_frame_export.mode_3d, the field is the z slice m_frame_export.slice_index or the mean of the spins
+ * along z (the magnetization profile of each column).
+ *
+ * @return std::vector<double> Field of size size_x * size_y, x is the fastest axis.
+ */
+std::vector<double> ising_3d::compute_frame_field() const {
+    const std::size_t plane_size = m_size_x * m_size_y;
+    if (m_frame_export.mode_3d == frame_mode_3d::slice) {
+        const std::size_t z = std::min(m_frame_export.slice_index, m_size_z - 1);
+        return std::vector<double>(m_spins.begin() + z * plane_size, m_spins.begin() + (z + 1) * plane_size);
+    }
+    std::vector<double> field(plane_size, 0.0);
+    for (std::size_t z = 0; z < m_size_z; z++) {
+        const double* plane = m_spins.data() + z * plane_size;
+        for (std::size_t index = 0; index < plane_size; index++) {
+            field[index] += plane[index];
+        }
     }
+    for (double& value : field) {
+        value /= static_cast<double>(m_size_z);
+    }
+    return field;
 }
 
 void ising_3d::export_to_file(const std::string& filename) const {
@@ -193,7 +449,7 @@ void ising_3d::export_to_file(const std::string& filename) const {
     file << "X,Y,Z,Spin\n";
     for (std::size_t x = 0; x < m_size_x; x++) {
         for (std::size_t y = 0; y < m_size_y; y++) {
-            for (std::size_t z = 0; z < m_size_y; z++) {
+            for (std::size_t z = 0; z < m_size_z; z++) {
                 file << x / size_x << "," << y / size_y << "," << z / size_z << "," << get_spin(x, y, z) << "\n";
             }
         }
@@ -17,6 +17,7 @@
 #include <cmath>
 #include <iostream>
 #include <random>
+#include <string>
 #include <vector>
 
 #include "ising_2d.hpp"
@@ -30,8 +31,17 @@ class ising_3d : public ising_base {
     double      m_y_anisotropic_factor = 1.0;
     double      m_z_anisotropic_factor = 1.0;
 
+    bool metropolis_attempt(std::size_t                       x,
+                            std::size_t                       y,
+                            std::size_t                       z,
+                            std::mt19937&                     random_engine,
+                            std::uniform_real_distribution<>& double_distribution);
+    void first_touch(const double* spins) override;
+    void prefetch_planes(std::size_t z, std::size_t nb_planes) const;
+    void write_back_planes(std::size_t z, std::size_t nb_planes) const;
+
  public:
-    ising_3d(std::size_t size_x, std::size_t size_y, std::size_t size_z, double temperature = 1.0);
+    ising_3d(std::size_t size_x, std::size_t size_y, std::size_t size_z, double temperature = 1.0, const std::string& storage_directory = "");
 
     void set_x_anisotropic_factor(double x_anisotropic_factor) { m_x_anisotropic_factor = x_anisotropic_factor; }
     void set_y_anisotropic_factor(double y_anisotropic_factor) { m_y_anisotropic_factor = y_anisotropic_factor; }
@@ -45,11 +55,18 @@ class ising_3d : public ising_base {
     double compute_total_energy() const override;
     double compute_specific_heat() const override;
     double compute_susceptibility() const override;
+    double compute_flip_delta_energy(std::size_t index) const override;
+
+    std::array<std::size_t, 3>              get_shape() const override { return {m_size_x, m_size_y, m_size_z}; }
+    std::vector<std::array<std::size_t, 3>> get_bond_displacements() const override { return {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {1, 1, 0}}; }
+    std::unique_ptr<ising_base>             clone() const override { return std::make_unique<ising_3d>(*this); }
 
-    void metropolis_step();
+    void metropolis_step() override;
+    void metropolis_step_parallel(int nb_threads);
 
     ising_result metropolis_simulation(std::size_t nb_steps, const double convergence_threshold);
     void         metropolis_simulation_with_export(std::size_t nb_steps, const std::string& filename);
 
-    void export_to_file(const std::string& filename) const;
+    std::vector<double> compute_frame_field() const;
+    void                export_to_file(const std::string& filename) const;
 };
\ No newline at end of file
@@ -16,14 +16,123 @@
 #include <chrono>
 #include <cmath>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <stdexcept>
 #include <vector>
 
+#include "correlation.hpp"
+#include "domains.hpp"
+
+/**
+ * @brief Make sure there is one random engine per thread of the parallel sweeps, seeded from the main engine.
+ *
+ * @param nb_threads
+ */
+void ising_base::prepare_thread_engines(std::size_t nb_threads) {
+    while (m_thread_engines.size() < nb_threads) {
+        m_thread_engines.emplace_back(m_random_engine());
+    }
+    if (m_trajectory) {
+        m_trajectory->prepare_threads(nb_threads);
+    }
+}
+
 void ising_base::initialize_random(double probability) {
     std::uniform_real_distribution<double> distribution(0.0, 1.0);
     std::generate(m_spins.begin(), m_spins.end(), [&]() { return distribution(m_random_engine) < probability ? 1.0 : -1.0; });
+    refresh_long_range_field();
+    invalidate_trajectory();
+}
+
+/**
+ * @brief Move the spins to a new buffer placed by first_touch() with the current thread count.
+ *
+ * File-backed spins stay where they are: their pages belong to the page cache and copying the file would double it.
+ */
+void ising_base::relocate_spins() {
+    if (is_file_backed() || m_spins.empty()) {
+        return;
+    }
+    spin_vector previous = std::move(m_spins);
+    m_spins              = spin_vector(previous.get_allocator());
+    m_spins.resize(previous.size());
+    first_touch(previous.data());
 }
 
 double ising_base::compute_total_magnetization() const {
     double total_magnetization = std::accumulate(m_spins.begin(), m_spins.end(), 0.0) / static_cast<double>(m_spins.size());
-}
\ No newline at end of file
+    return total_magnetization;
+}
+/**
+ * @brief Convert a sweep order name (random, sequential, strided) to a sweep_order.
+ *
+ * @param name
+ * @return sweep_order
+ */
+sweep_order parse_sweep_order(const std::string& name) {
+    if (name == "random") {
+        return sweep_order::random;
+    }
+    if (name == "sequential") {
+        return sweep_order::sequential;
+    }
+    if (name == "strided") {
+        return sweep_order::strided;
+    }
+    throw std::invalid_argument("Unknown sweep order: " + name + " (expected random, sequential or strided)");
+}
+
+generator<sweep_record> ising_base::simulate(std::size_t nb_steps, simulation_options options) {
+    std::unique_ptr<correlation_recorder> correlations;
+    if (m_correlation_stride > 0) {
+        correlations = std::make_unique<correlation_recorder>(m_correlation_filename, get_shape());
+    }
+    std::unique_ptr<domain_recorder> domains;
+    if (m_domain_stride > 0) {
+        int nb_domain_threads = m_domain_threads;
+#ifdef _OPENMP
+        if (nb_domain_threads <= 0) {
+            nb_domain_threads = omp_get_max_threads();
+        }
+#endif
+        domains = std::make_unique<domain_recorder>(m_domain_filename, get_shape(), get_bond_displacements(), nb_domain_threads);
+    }
+    const std::size_t record_stride = std::max<std::size_t>(1, options.record_stride);
+    const double      nb_spins      = static_cast<double>(m_spins.size());
+    for (std::size_t sweep = 0; sweep < nb_steps; sweep++) {
+        if (options.stop_token.stop_requested()) {
+            co_return;
+        }
+        metropolis_step();
+        m_number_iterations++;
+        if (correlations && m_number_iterations % m_correlation_stride == 0) {
+            correlations->record(m_number_iterations, m_spins.data());
+        }
+        if (domains && m_number_iterations % m_domain_stride == 0) {
+            domains->record(m_number_iterations, m_spins.data());
+        }
+        if ((sweep + 1) % record_stride != 0) {
+            continue;
+        }
+        const sweep_record record{sweep,
+                                  m_number_iterations,
+                                  compute_total_energy(),
+                                  std::accumulate(m_spins.begin(), m_spins.end(), 0.0),
+                                  static_cast<double>(m_number_modified_spins) / nb_spins};
+        if (options.on_progress) {
+            options.on_progress(record);
+        }
+        co_yield record;
+        if (options.stop_condition && options.stop_condition(record)) {
+            co_return;
+        }
+    }
+}
+
+std::function<void(const sweep_record&)> console_progress(std::size_t nb_steps) {
+    return [nb_steps](const sweep_record& record) {
+        std::cout << "\r Iteration " << record.sweep << " / " << nb_steps << " (" << (record.sweep * 100.0 / nb_steps) << "%)"
+                  << std::flush;
+    };
+}
@@ -15,10 +15,37 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <random>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
 #include <vector>
 
+#include "frame_renderer.hpp"
+#include "generator.hpp"
+#include "long_range.hpp"
+#include "spin_allocator.hpp"
+#include "trajectory.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * @brief Index of the calling thread in the current OpenMP team (0 without OpenMP).
+ */
+inline std::size_t thread_index() {
+#ifdef _OPENMP
+    return static_cast<std::size_t>(omp_get_thread_num());
+#else
+    return 0;
+#endif
+}
+
 struct ising_result {
     double energy;
     double magnetization;
@@ -26,6 +53,55 @@ struct ising_result {
     double susceptibility;
 };
 
+/**
+ * @brief Order in which a Metropolis sweep visits the lattice.
+ *
+ * Whatever the order, a sweep makes exactly N flip attempts, N being the number of spins:
+ * - random: N sites drawn uniformly (each coordinate in its own range), with replacement.
+ * - sequential: every site once, in memory order (typewriter, x fastest).
+ * - strided: every site once, first the even then the odd rows (2D) or planes (3D), each one in memory order.
+ *   Rows (planes) of the same parity do not interact, except the first and the last one of an odd number of rows,
+ *   neighbors through the periodic boundary: metropolis_step_parallel() updates that last row separately.
+ *
+ * The sequential orders stream through memory and are prefetcher friendly, the random order is not.
+ */
+enum class sweep_order { random, sequential, strided };
+
+sweep_order parse_sweep_order(const std::string& name);
+
+/**
+ * @brief Observables of the lattice after one Metropolis sweep, as yielded by ising_base::simulate().
+ *
+ */
+struct sweep_record {
+    std::size_t sweep;          // Index of the sweep in the simulation, from 0.
+    std::size_t iteration;      // Total number of sweeps performed by the lattice (get_number_iterations()).
+    double      energy;         // compute_total_energy().
+    double      magnetization;  // Sum of the spins.
+    double      acceptance;     // Fraction of the flip attempts of the sweep which were accepted.
+};
+
+/**
+ * @brief Decimation, callbacks and cancellation of ising_base::simulate().
+ *
+ * - record_stride: a record is produced after every record_stride sweeps (the observables of the other sweeps are not
+ *   computed at all).
+ * - on_progress: called with each record, before it is yielded.
+ * - stop_condition: the simulation ends after the first record for which it returns true.
+ * - stop_token: checked before each sweep, the simulation ends as soon as a stop is requested.
+ */
+struct simulation_options {
+    std::size_t                              record_stride = 1;
+    std::function<void(const sweep_record&)> on_progress;
+    std::function<bool(const sweep_record&)> stop_condition;
+    std::stop_token                          stop_token;
+};
+
+/**
+ * @brief Progress callback printing "Iteration i / n (p%)" on a single console line.
+ */
+std::function<void(const sweep_record&)> console_progress(std::size_t nb_steps);
+
 /**
  * @brief Base class for simple Ising model implementation.
  *
@@ -33,12 +109,51 @@ struct ising_result {
 class ising_base {
  protected:
     std::mt19937        m_random_engine;
+    std::vector<std::mt19937> m_thread_engines;
     double              m_temperature;
-    std::vector<double> m_spins;
+    spin_vector         m_spins;
 
     std::size_t m_number_iterations     = 0;
     std::size_t m_number_modified_spins = 0;
 
+    sweep_order          m_sweep_order    = sweep_order::random;
+    int                  m_number_threads = 1;
+    frame_export_options m_frame_export;
+
+    void prepare_thread_engines(std::size_t nb_threads);
+
+    /**
+     * @brief Write the spins (all up, or a copy of spins when not null) with the decomposition of the parallel sweep
+     * over m_number_threads threads, so that the first write places each page on the node of the thread updating it.
+     */
+    virtual void first_touch(const double* spins) = 0;
+    void         relocate_spins();
+
+    std::size_t m_correlation_stride = 0;
+    std::string m_correlation_filename;
+    std::size_t m_domain_stride  = 0;
+    int         m_domain_threads = 0;
+    std::string m_domain_filename;
+
+    std::optional<long_range_field> m_long_range;
+    trajectory_slot                 m_trajectory;
+
+    /**
+     * @brief End of a Metropolis sweep for the trajectory recorder (called by the sweeps of the derived classes).
+     */
+    void record_trajectory_sweep() {
+        if (m_trajectory) {
+            m_trajectory->end_sweep(m_spins.data());
+        }
+    }
+
+    /**
+     * @brief Site energy of the long-range interaction, -s_i h_i (0 when the long-range mode is off).
+     */
+    double compute_long_range_energy(std::size_t index) const {
+        return m_long_range ? -m_spins[index] * m_long_range->local_field(index) : 0.0;
+    }
+
  public:
     ising_base(double temperature) : m_random_engine(std::random_device{}()), m_temperature(temperature){};
     ising_base(double temperature, std::size_t nb_spins)
@@ -51,6 +166,8 @@ class ising_base {
         std::fill(m_spins.begin(), m_spins.end(), 1.0);
         m_number_iterations     = 0;
         m_number_modified_spins = 0;
+        refresh_long_range_field();
+        invalidate_trajectory();
     }
     void resize_spins(std::size_t size) {
         m_spins.resize(size);
@@ -58,10 +175,192 @@ class ising_base {
     }
     void        initialize_random(double probability);
     void        set_temperature(double temperature) { m_temperature = temperature; }
+    void        set_seed(unsigned int seed) { m_random_engine.seed(seed); }
+    /**
+     * @brief Order of the flip attempts of the serial sweeps. The random order has no locality and would page the
+     * whole file in and out at every sweep: it is refused on file-backed lattices (std::logic_error), which sweep in
+     * sequential order by default.
+     */
+    void set_sweep_order(sweep_order order) {
+        if (order == sweep_order::random && is_file_backed()) {
+            throw std::logic_error("The random sweep order is not available on file-backed lattices.");
+        }
+        m_sweep_order = order;
+    }
+    sweep_order get_sweep_order() const { return m_sweep_order; }
+
+    /**
+     * @brief Number of OpenMP threads of metropolis_step(): with more than one thread, the sweep is the parallel
+     * strided sweep (metropolis_step_parallel() of the derived class) whatever the sweep order.
+     *
+     * Changing the count moves the in-memory spins to a new buffer, first touched with the new decomposition: the
+     * pointers returned by get_spin_data() are invalidated.
+     */
+    void set_number_threads(int nb_threads) {
+        nb_threads = std::max(nb_threads, 1);
+        if (nb_threads != m_number_threads) {
+            m_number_threads = nb_threads;
+            relocate_spins();
+        }
+    }
+    int  get_number_threads() const { return m_number_threads; }
+    void        set_frame_export(const frame_export_options& options) { m_frame_export = options; }
+
+    /**
+     * @brief Measure G(r), S(k) and the correlation length every stride iterations of metropolis_simulation
+     * (0 disables the measurement). The results are written to filename_correlation.csv and
+     * filename_correlation_length.csv.
+     */
+    void set_correlation_measurement(std::size_t stride, const std::string& filename) {
+        m_correlation_stride   = stride;
+        m_correlation_filename = filename;
+    }
+
+    /**
+     * @brief Label the same-spin domains every stride iterations of metropolis_simulation (0 disables the
+     * measurement). The domain count, size histogram, largest-domain fraction and interface length are written to
+     * filename_domains.csv (see domain_analyzer).
+     *
+     * The labeling runs on nb_threads threads, independently of the thread count of the sweeps (0: the OpenMP default,
+     * omp_get_max_threads() when the simulation starts). It keeps one 64-bit union-find entry per site in memory, so it
+     * is not available on file-backed lattices (std::logic_error).
+     */
+    void set_domain_measurement(std::size_t stride, const std::string& filename, int nb_threads = 0) {
+        if (stride > 0 && is_file_backed()) {
+            throw std::logic_error("The domain measurement is not available on file-backed lattices.");
+        }
+        m_domain_stride   = stride;
+        m_domain_threads  = nb_threads;
+        m_domain_filename = filename;
+    }
+    double      get_temperature() const { return m_temperature; }
     std::size_t get_number_iterations() const { return m_number_iterations; }
+    std::size_t get_number_spins() const { return m_spins.size(); }
+
+    /**
+     * @brief Move the spins to a memory-mapped file of the given directory, or back to memory for an empty directory.
+     *
+     * A file-backed lattice can be larger than the RAM: the kernel pages the spins in and out, and the sequential and
+     * strided sweeps of ising_3d stream through the file slab by slab (see spin_memory::allocate_file_backed()).
+     * Its clones get their own file in the same directory. A random sweep order becomes sequential (see
+     * set_sweep_order()).
+     */
+    void set_spin_storage(const std::string& directory) {
+        spin_vector spins(m_spins.begin(), m_spins.end(), spin_allocator<double>(directory));
+        m_spins = std::move(spins);
+        if (is_file_backed() && m_sweep_order == sweep_order::random) {
+            m_sweep_order = sweep_order::sequential;
+        }
+    }
+    bool is_file_backed() const { return m_spins.get_allocator().is_file_backed(); }
+
+    const spin_vector& get_spins() const { return m_spins; }
+    double*            get_spin_data() { return m_spins.data(); }
+    void               set_spins(const std::vector<double>& spins) {
+        m_spins.assign(spins.begin(), spins.end());
+        refresh_long_range_field();
+        invalidate_trajectory();
+    }
+
+    /**
+     * @brief Add the long-range interaction of the given kernel to the nearest-neighbor couplings.
+     *
+     * The local field is maintained by FFT convolution (see long_range_field). Spins written directly through
+     * get_spin_data() must be followed by a call to refresh_long_range_field(). The parallel sweeps are not available in
+     * this mode, every spin interacting with all the others.
+     */
+    void set_long_range_interaction(const long_range_parameters& parameters) {
+        m_long_range.emplace(get_shape(), parameters);
+        refresh_long_range_field();
+    }
+    void disable_long_range_interaction() { m_long_range.reset(); }
+    bool has_long_range_interaction() const { return m_long_range.has_value(); }
+    void refresh_long_range_field() {
+        if (m_long_range) {
+            m_long_range->refresh(m_spins.data());
+        }
+    }
+
+    /**
+     * @brief Record the flips of every following sweep to a trajectory file, with a keyframe every keyframe_interval
+     * sweeps (see trajectory_recorder). The file starts with the current configuration.
+     *
+     * Spins written directly through get_spin_data() must be followed by a call to invalidate_trajectory(), so that
+     * the next sweep is recorded as a keyframe. Clones of the lattice are not recorded.
+     */
+    void start_trajectory_recording(const std::string& filename, std::size_t keyframe_interval) {
+        m_trajectory.reset(std::make_unique<trajectory_recorder>(filename, get_shape(), keyframe_interval, m_spins.data()));
+    }
+    void stop_trajectory_recording() { m_trajectory.reset(); }
+    bool is_recording_trajectory() const { return static_cast<bool>(m_trajectory); }
+    void invalidate_trajectory() {
+        if (m_trajectory) {
+            m_trajectory->invalidate();
+        }
+    }
+
+    /**
+     * @brief Access to a spin through its linear index in the spin array.
+     *
+     * The linear index follows the storage order of the derived class (x is the fastest axis).
+     */
+    double get_spin_at(std::size_t index) const { return m_spins[index]; }
+    void   flip_spin_at(std::size_t index) {
+        m_spins[index] = -m_spins[index];
+        if (m_long_range) {
+            m_long_range->notify_change(index, 2.0 * m_spins[index], m_spins.data());
+        }
+        if (m_trajectory) {
+            m_trajectory->record_flip(thread_index(), index);
+        }
+    }
+    void set_spin_at(std::size_t index, double value) {
+        const double delta = value - m_spins[index];
+        m_spins[index]     = value;
+        if (m_long_range) {
+            m_long_range->notify_change(index, delta, m_spins.data());
+        }
+        if (m_trajectory && delta != 0.0) {
+            m_trajectory->record_flip(thread_index(), index);
+        }
+    }
 
     double         compute_total_magnetization() const;
     virtual double compute_total_energy() const   = 0;
     virtual double compute_specific_heat() const  = 0;
     virtual double compute_susceptibility() const = 0;
+
+    /**
+     * @brief Energy variation of the Hamiltonian if the spin at the linear index is flipped.
+     *
+     * This is the quantity used in the Metropolis acceptance test, i.e. -2 * compute_energy(site).
+     */
+    virtual double compute_flip_delta_energy(std::size_t index) const = 0;
+
+    /**
+     * @brief Lattice dimensions {size_x, size_y, size_z}, with size_z = 1 for a 2D lattice.
+     */
+    virtual std::array<std::size_t, 3> get_shape() const = 0;
+
+    /**
+     * @brief Bonds of the Hamiltonian as forward displacements {dx, dy, dz}, each bond appearing once.
+     */
+    virtual std::vector<std::array<std::size_t, 3>> get_bond_displacements() const = 0;
+
+    virtual void metropolis_step() = 0;
+
+    /**
+     * @brief Run nb_steps Metropolis sweeps lazily, yielding the observables as the simulation goes.
+     *
+     * The sweeps are only performed when the consumer asks for the next record, so that breaking out of the loop (or
+     * destroying the generator) stops the simulation. The correlation and domain measurements
+     * (set_correlation_measurement(), set_domain_measurement()) are performed along the way. The lattice must outlive
+     * the generator.
+     */
+    generator<sweep_record> simulate(std::size_t nb_steps, simulation_options options = {});
+
+    /**
+     * @brief Polymorphic copy of the lattice (spins, couplings and random engine state).
+     */
+    virtual std::unique_ptr<ising_base> clone() const = 0;
 };
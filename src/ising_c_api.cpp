@@ -0,0 +1,197 @@
+/**
+ * @file ising_c_api.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Implementation of the C interface of the Ising library.
+ * @version 0.1
+ * @date 2022-09-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "ising_c_api.h"
+
+#include <exception>
+#include <memory>
+#include <numeric>
+#include <string>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+
+struct ising_lattice {
+    std::unique_ptr<ising_base> model;
+    int                         dimension;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+int set_error(int code, const std::string& message) {
+    last_error = message;
+    return code;
+}
+
+/**
+ * @brief Run an operation on a lattice, converting invalid handles and C++ exceptions into error codes.
+ */
+template <typename Function>
+int guarded_call(ising_lattice* lattice, Function&& function) {
+    if (lattice == nullptr || !lattice->model) {
+        return set_error(ISING_ERROR_INVALID_HANDLE, "invalid lattice handle");
+    }
+    try {
+        return function(*lattice);
+    } catch (const std::exception& e) {
+        return set_error(ISING_ERROR_EXCEPTION, e.what());
+    }
+}
+
+template <typename Model>
+ising_lattice* create_lattice(int dimension, std::unique_ptr<Model> model) {
+    ising_lattice* lattice = new ising_lattice{std::move(model), dimension};
+    lattice->model->reset_spins();
+    return lattice;
+}
+
+}  // namespace
+
+extern "C" {
+
+int ising_abi_version(void) { return ISING_ABI_VERSION; }
+
+const char* ising_last_error(void) { return last_error.c_str(); }
+
+ising_lattice* ising_create_2d(size_t size_x, size_t size_y, double temperature) {
+    if (size_x == 0 || size_y == 0) {
+        set_error(ISING_ERROR_INVALID_ARGUMENT, "lattice dimensions must be positive");
+        return nullptr;
+    }
+    try {
+        return create_lattice(2, std::make_unique<ising_2d>(size_x, size_y, temperature));
+    } catch (const std::exception& e) {
+        set_error(ISING_ERROR_EXCEPTION, e.what());
+        return nullptr;
+    }
+}
+
+ising_lattice* ising_create_3d(size_t size_x, size_t size_y, size_t size_z, double temperature) {
+    if (size_x == 0 || size_y == 0 || size_z == 0) {
+        set_error(ISING_ERROR_INVALID_ARGUMENT, "lattice dimensions must be positive");
+        return nullptr;
+    }
+    try {
+        return create_lattice(3, std::make_unique<ising_3d>(size_x, size_y, size_z, temperature));
+    } catch (const std::exception& e) {
+        set_error(ISING_ERROR_EXCEPTION, e.what());
+        return nullptr;
+    }
+}
+
+void ising_destroy(ising_lattice* lattice) { delete lattice; }
+
+int ising_set_seed(ising_lattice* lattice, unsigned int seed) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        handle.model->set_seed(seed);
+        return ISING_OK;
+    });
+}
+
+int ising_set_temperature(ising_lattice* lattice, double temperature) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        if (!(temperature > 0.0)) {
+            return set_error(ISING_ERROR_INVALID_ARGUMENT, "temperature must be positive");
+        }
+        handle.model->set_temperature(temperature);
+        return ISING_OK;
+    });
+}
+
+int ising_set_anisotropic_factors(ising_lattice* lattice, double x_factor, double y_factor, double z_factor) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        if (handle.dimension == 2) {
+            auto& model = static_cast<ising_2d&>(*handle.model);
+            model.set_x_anisotropic_factor(x_factor);
+            model.set_y_anisotropic_factor(y_factor);
+        } else {
+            auto& model = static_cast<ising_3d&>(*handle.model);
+            model.set_x_anisotropic_factor(x_factor);
+            model.set_y_anisotropic_factor(y_factor);
+            model.set_z_anisotropic_factor(z_factor);
+        }
+        return ISING_OK;
+    });
+}
+
+int ising_initialize_random(ising_lattice* lattice, double probability) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        handle.model->initialize_random(probability);
+        return ISING_OK;
+    });
+}
+
+int ising_reset_spins(ising_lattice* lattice) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        handle.model->reset_spins();
+        return ISING_OK;
+    });
+}
+
+int ising_metropolis_sweeps(ising_lattice* lattice, size_t nb_sweeps) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        for (size_t index_sweep = 0; index_sweep < nb_sweeps; index_sweep++) {
+            handle.model->metropolis_step();
+        }
+        return ISING_OK;
+    });
+}
+
+int ising_get_observables(ising_lattice* lattice, ising_observables* observables) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        if (observables == nullptr) {
+            return set_error(ISING_ERROR_INVALID_ARGUMENT, "observables must not be null");
+        }
+        // Summed here: ising_base::compute_total_magnetization() is the mean spin and only ising_2d hides it with the
+        // sum, so the lattice's own magnetization and susceptibility do not follow the same convention in 2D and 3D.
+        const ising_base& model         = *handle.model;
+        const double      nb_spins      = static_cast<double>(model.get_number_spins());
+        const double      magnetization = std::accumulate(model.get_spins().begin(), model.get_spins().end(), 0.0);
+        observables->energy             = model.compute_total_energy();
+        observables->magnetization      = magnetization;
+        observables->specific_heat      = model.compute_specific_heat();
+        observables->susceptibility     = magnetization * magnetization / nb_spins;
+        return ISING_OK;
+    });
+}
+
+double* ising_spin_buffer(ising_lattice* lattice) {
+    if (lattice == nullptr || !lattice->model) {
+        set_error(ISING_ERROR_INVALID_HANDLE, "invalid lattice handle");
+        return nullptr;
+    }
+    return lattice->model->get_spin_data();
+}
+
+int ising_spin_shape(ising_lattice* lattice, size_t shape[3], size_t* ndim) {
+    return guarded_call(lattice, [&](ising_lattice& handle) {
+        if (shape == nullptr || ndim == nullptr) {
+            return set_error(ISING_ERROR_INVALID_ARGUMENT, "shape and ndim must not be null");
+        }
+        const auto sizes = handle.model->get_shape();
+        if (handle.dimension == 2) {
+            *ndim    = 2;
+            shape[0] = sizes[1];
+            shape[1] = sizes[0];
+            shape[2] = 1;
+        } else {
+            *ndim    = 3;
+            shape[0] = sizes[2];
+            shape[1] = sizes[1];
+            shape[2] = sizes[0];
+        }
+        return ISING_OK;
+    });
+}
+
+}  // extern "C"
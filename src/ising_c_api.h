@@ -0,0 +1,76 @@
+/**
+ * @file ising_c_api.h
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Stable C interface of the Ising library, exported by the shared library (libising.so).
+ * @version 0.1
+ * @date 2022-09-14
+ *
+ * @copyright Copyright (c) 2022
+ *
+ * All the functions returning an int return ISING_OK on success and a negative error code otherwise; the message of
+ * the last error raised on the calling thread is available through ising_last_error().
+ *
+ * The spin buffer returned by ising_spin_buffer() is the live storage of the lattice (one double per spin, +1 or -1),
+ * laid out in C order with the shape given by ising_spin_shape(): (size_y, size_x) for a 2D lattice and
+ * (size_z, size_y, size_x) for a 3D lattice. It stays valid until ising_destroy() is called.
+ */
+
+#ifndef ISING_C_API_H
+#define ISING_C_API_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#define ISING_API __declspec(dllexport)
+#else
+#define ISING_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ISING_ABI_VERSION 1
+
+#define ISING_OK 0
+#define ISING_ERROR_INVALID_HANDLE -1
+#define ISING_ERROR_INVALID_ARGUMENT -2
+#define ISING_ERROR_EXCEPTION -3
+
+typedef struct ising_lattice ising_lattice;
+
+/**
+ * Instantaneous observables of the current configuration, the same for 2D and 3D lattices (N is the number of spins,
+ * energies in units of the coupling J, k_B = 1).
+ */
+typedef struct ising_observables {
+    double energy;          // Sum over the sites of their local energy (each bond counted twice), as compute_total_energy().
+    double magnetization;   // Sum of the spins M, in [-N, N] (not the mean spin).
+    double specific_heat;   // energy^2 / N.
+    double susceptibility;  // M^2 / N.
+} ising_observables;
+
+ISING_API int         ising_abi_version(void);
+ISING_API const char* ising_last_error(void);
+
+ISING_API ising_lattice* ising_create_2d(size_t size_x, size_t size_y, double temperature);
+ISING_API ising_lattice* ising_create_3d(size_t size_x, size_t size_y, size_t size_z, double temperature);
+ISING_API void           ising_destroy(ising_lattice* lattice);
+
+ISING_API int ising_set_seed(ising_lattice* lattice, unsigned int seed);
+ISING_API int ising_set_temperature(ising_lattice* lattice, double temperature);
+ISING_API int ising_set_anisotropic_factors(ising_lattice* lattice, double x_factor, double y_factor, double z_factor);
+ISING_API int ising_initialize_random(ising_lattice* lattice, double probability);
+ISING_API int ising_reset_spins(ising_lattice* lattice);
+
+ISING_API int ising_metropolis_sweeps(ising_lattice* lattice, size_t nb_sweeps);
+ISING_API int ising_get_observables(ising_lattice* lattice, ising_observables* observables);
+
+ISING_API double* ising_spin_buffer(ising_lattice* lattice);
+ISING_API int     ising_spin_shape(ising_lattice* lattice, size_t shape[3], size_t* ndim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ISING_C_API_H
@@ -0,0 +1,150 @@
+/**
+ * @file long_range.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Long-range (power-law or dipolar) interactions, with the local field computed by FFT convolution.
+ * @version 0.1
+ * @date 2022-10-03
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "long_range.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief Parse a long-range interaction specification.
+ *
+ * @param specification "power_law:coupling[:exponent]" or "dipolar:coupling".
+ * @return long_range_parameters
+ */
+long_range_parameters parse_long_range(const std::string& specification) {
+    std::vector<std::string> fields;
+    std::istringstream       stream(specification);
+    std::string              field;
+    while (std::getline(stream, field, ':')) {
+        fields.push_back(field);
+    }
+    long_range_parameters parameters;
+    if (fields.empty() || fields.size() > 3) {
+        throw std::invalid_argument("Invalid long-range specification: " + specification);
+    }
+    if (fields[0] == "power_law") {
+        parameters.kernel = long_range_kernel::power_law;
+    } else if (fields[0] == "dipolar" && fields.size() <= 2) {
+        parameters.kernel = long_range_kernel::dipolar;
+    } else {
+        throw std::invalid_argument("Invalid long-range specification: " + specification +
+                                    " (expected power_law:coupling[:exponent] or dipolar:coupling)");
+    }
+    if (fields.size() > 1) {
+        parameters.coupling = std::stod(fields[1]);
+    }
+    if (fields.size() > 2) {
+        parameters.exponent = std::stod(fields[2]);
+    }
+    return parameters;
+}
+
+/**
+ * @brief Construct a new long range field::long range field object.
+ *
+ * The kernel is tabulated for every displacement of the periodic lattice and transformed once.
+ *
+ * @param shape
+ * @param parameters
+ */
+long_range_field::long_range_field(const std::array<std::size_t, 3>& shape, const long_range_parameters& parameters)
+    : m_shape(shape),
+      m_parameters(parameters),
+      m_plan(shape) {
+    const std::size_t nb_sites = m_shape[0] * m_shape[1] * m_shape[2];
+    m_max_pending_flips        = parameters.max_pending_flips;
+    if (m_max_pending_flips == 0) {
+        const double size   = static_cast<double>(nb_sites);
+        m_max_pending_flips = static_cast<std::size_t>(std::ceil(std::sqrt(size * std::max(1.0, std::log2(size)))));
+    }
+    m_kernel.resize(nb_sites);
+    for (std::size_t dz = 0; dz < m_shape[2]; dz++) {
+        for (std::size_t dy = 0; dy < m_shape[1]; dy++) {
+            for (std::size_t dx = 0; dx < m_shape[0]; dx++) {
+                m_kernel[dx + m_shape[0] * (dy + m_shape[1] * dz)] = kernel_at(dx, dy, dz);
+            }
+        }
+    }
+    m_kernel_transform.assign(m_kernel.begin(), m_kernel.end());
+    m_plan.forward(m_kernel_transform);
+    m_buffer.resize(nb_sites);
+    m_reference_field.assign(nb_sites, 0.0);
+    m_pending_flips.reserve(m_max_pending_flips + 1);
+}
+
+/**
+ * @brief Kernel for a displacement given by its (non-negative, periodic) components, with the minimum image convention.
+ *
+ * @param dx
+ * @param dy
+ * @param dz
+ * @return double
+ */
+double long_range_field::kernel_at(std::size_t dx, std::size_t dy, std::size_t dz) const {
+    if (dx == 0 && dy == 0 && dz == 0) {
+        return 0.0;
+    }
+    auto minimum_image = [](std::size_t delta, std::size_t size) { return static_cast<double>(std::min(delta, size - delta)); };
+    const double x        = minimum_image(dx, m_shape[0]);
+    const double y        = minimum_image(dy, m_shape[1]);
+    const double z        = minimum_image(dz, m_shape[2]);
+    const double distance = std::sqrt(x * x + y * y + z * z);
+    if (m_parameters.kernel == long_range_kernel::power_law) {
+        return m_parameters.coupling / std::pow(distance, m_parameters.exponent);
+    }
+    const double cos_square = z * z / (distance * distance);
+    return -m_parameters.coupling * (1.0 - 3.0 * cos_square) / (distance * distance * distance);
+}
+
+/**
+ * @brief h = IFFT(FFT(K) * FFT(s)) / N.
+ *
+ * @param spins
+ */
+void long_range_field::refresh(const double* spins) {
+    const std::size_t nb_sites = m_buffer.size();
+    for (std::size_t index = 0; index < nb_sites; index++) {
+        m_buffer[index] = spins[index];
+    }
+    m_plan.forward(m_buffer);
+    for (std::size_t index = 0; index < nb_sites; index++) {
+        m_buffer[index] *= m_kernel_transform[index];
+    }
+    m_plan.inverse(m_buffer);
+    const double normalization = 1.0 / static_cast<double>(nb_sites);
+    for (std::size_t index = 0; index < nb_sites; index++) {
+        m_reference_field[index] = m_buffer[index].real() * normalization;
+    }
+    m_pending_flips.clear();
+}
+
+/**
+ * @brief Field of the reference configuration, corrected by the pending flips.
+ *
+ * @param index
+ * @return double
+ */
+double long_range_field::local_field(std::size_t index) const {
+    const std::size_t x     = index % m_shape[0];
+    const std::size_t y     = (index / m_shape[0]) % m_shape[1];
+    const std::size_t z     = index / (m_shape[0] * m_shape[1]);
+    double            field = m_reference_field[index];
+    for (const pending_flip& flip : m_pending_flips) {
+        const std::size_t dx = x >= flip.x ? x - flip.x : x + m_shape[0] - flip.x;
+        const std::size_t dy = y >= flip.y ? y - flip.y : y + m_shape[1] - flip.y;
+        const std::size_t dz = z >= flip.z ? z - flip.z : z + m_shape[2] - flip.z;
+        field += flip.delta * m_kernel[dx + m_shape[0] * (dy + m_shape[1] * dz)];
+    }
+    return field;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file long_range.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Long-range (power-law or dipolar) interactions, with the local field computed by FFT convolution.
+ * @version 0.1
+ * @date 2022-10-03
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "fft.hpp"
+
+enum class long_range_kernel { power_law, dipolar };
+
+/**
+ * @brief Long-range coupling added to the nearest-neighbor Hamiltonian: H_lr = -1/2 sum_{i != j} K(r_ij) s_i s_j.
+ *
+ * - power_law: K(r) = coupling / |r|^exponent (ferromagnetic for a positive coupling).
+ * - dipolar: K(r) = -coupling (1 - 3 (r_z / |r|)^2) / |r|^3, the interaction of moments perpendicular to the xy plane
+ *   (the easy axis of a thin film with perpendicular anisotropy). In 2D it reduces to -coupling / |r|^3.
+ *
+ * Distances use the minimum image convention of the periodic lattice (no Ewald summation of the periodic images).
+ * max_pending_flips bounds the number of flips corrected one by one before the field is recomputed by FFT
+ * (0 selects sqrt(N log2 N)).
+ */
+struct long_range_parameters {
+    long_range_kernel kernel            = long_range_kernel::power_law;
+    double            coupling          = 1.0;
+    double            exponent          = 3.0;
+    std::size_t       max_pending_flips = 0;
+};
+
+/**
+ * @brief Parse "power_law:coupling[:exponent]" or "dipolar:coupling".
+ */
+long_range_parameters parse_long_range(const std::string& specification);
+
+/**
+ * @brief Local field h_i = sum_j K(r_ij) s_j of the long-range interaction.
+ *
+ * The field of a reference configuration is obtained in O(N log N) as the circular convolution of the spins with the
+ * kernel, through the FFT of both. The spin changes since the reference are kept in a list of pending flips and added
+ * exactly to the field when it is queried, in O(number of pending flips). Once the list is full, the reference field is
+ * recomputed by FFT. A Metropolis attempt therefore costs O(sqrt(N log N)) instead of the O(N) of a direct sum.
+ */
+class long_range_field {
+ private:
+    struct pending_flip {
+        std::size_t x;
+        std::size_t y;
+        std::size_t z;
+        double      delta;
+    };
+
+    std::array<std::size_t, 3> m_shape;
+    long_range_parameters      m_parameters;
+    std::size_t                m_max_pending_flips;
+    std::vector<double>        m_kernel;
+    complex_vector             m_kernel_transform;
+    fft_plan_nd                m_plan;
+    complex_vector             m_buffer;
+    std::vector<double>        m_reference_field;
+    std::vector<pending_flip>  m_pending_flips;
+
+    double kernel_at(std::size_t dx, std::size_t dy, std::size_t dz) const;
+
+ public:
+    long_range_field(const std::array<std::size_t, 3>& shape, const long_range_parameters& parameters);
+
+    const long_range_parameters& get_parameters() const { return m_parameters; }
+
+    /**
+     * @brief K(r) for the displacement of linear index displacement (minimum image), K(0) = 0.
+     */
+    double kernel(std::size_t displacement) const { return m_kernel[displacement]; }
+
+    /**
+     * @brief Recompute the field of the given spins by FFT and clear the pending flips.
+     */
+    void refresh(const double* spins);
+
+    /**
+     * @brief Record that the spin at index changed by delta (2 s_new for a flip). spins is the updated configuration,
+     * from which the field is recomputed when the list of pending flips is full.
+     */
+    void notify_change(std::size_t index, double delta, const double* spins) {
+        m_pending_flips.push_back({index % m_shape[0], (index / m_shape[0]) % m_shape[1], index / (m_shape[0] * m_shape[1]), delta});
+        if (m_pending_flips.size() > m_max_pending_flips) {
+            refresh(spins);
+        }
+    }
+
+    double local_field(std::size_t index) const;
+};
@@ -0,0 +1,311 @@
+/**
+ * @file spin_allocator.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Allocator for the spin and scratch buffers: huge pages, per-thread reuse and no implicit first touch.
+ * @version 0.1
+ * @date 2022-09-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "spin_allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace spin_memory {
+
+namespace {
+
+constexpr std::size_t cache_line_size  = 64;
+constexpr std::size_t max_cached_bytes = std::size_t{256} << 20;
+// Every cached buffer spans at least one huge page, so the byte budget also bounds the number of entries.
+constexpr std::size_t max_cached_buffers = max_cached_bytes / huge_page_size;
+
+std::size_t round_up(std::size_t value, std::size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+bool use_huge_pages(std::size_t bytes) { return bytes >= huge_page_size; }
+
+#if defined(__linux__)
+void* map_huge_pages(std::size_t bytes) {
+    const std::size_t size = round_up(bytes, huge_page_size);
+#ifdef MAP_HUGETLB
+    if (std::getenv("ISING_HUGETLB") != nullptr) {
+        void* pointer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pointer != MAP_FAILED) {
+            return pointer;
+        }
+    }
+#endif
+    // Over-allocate by one huge page and trim the ends so that the buffer starts on a 2 MB boundary.
+    void* raw = mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    const std::uintptr_t raw_address = reinterpret_cast<std::uintptr_t>(raw);
+    const std::uintptr_t address     = round_up(raw_address, huge_page_size);
+    if (address > raw_address) {
+        munmap(raw, address - raw_address);
+    }
+    const std::uintptr_t end = raw_address + size + huge_page_size;
+    if (end > address + size) {
+        munmap(reinterpret_cast<void*>(address + size), end - (address + size));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(address), size, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void*>(address);
+}
+
+void unmap_huge_pages(void* pointer, std::size_t bytes) noexcept { munmap(pointer, round_up(bytes, huge_page_size)); }
+#else
+void* map_huge_pages(std::size_t bytes) {
+    void* pointer = std::aligned_alloc(huge_page_size, round_up(bytes, huge_page_size));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void unmap_huge_pages(void* pointer, std::size_t) noexcept { std::free(pointer); }
+#endif
+
+/**
+ * @brief NUMA node of the CPU the calling thread is running on (0 when unknown).
+ */
+unsigned current_numa_node() noexcept {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu  = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return node;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Bytes held by the arenas of all the threads.
+ */
+std::atomic<std::size_t> cached_bytes{0};
+
+/**
+ * @brief Large buffer released by a thread, with the NUMA node the thread was running on.
+ */
+struct cached_buffer {
+    std::size_t bytes;
+    void*       pointer;
+    unsigned    node;
+};
+
+/**
+ * @brief Large buffers released by a thread, waiting to be reused by the same thread while it runs on the same NUMA
+ * node (always, for pinned threads), so that the reused pages are local to it.
+ *
+ * The entries are reserved by the first large allocation of the thread, so that caching a buffer in deallocate() never
+ * allocates: a thread that never allocated a large buffer (or whose arena is full) returns the buffers it frees to the
+ * system.
+ */
+struct thread_arena {
+    std::vector<cached_buffer> buffers;
+
+    ~thread_arena() { clear(); }
+
+    void pop_front() noexcept {
+        cached_bytes -= buffers.front().bytes;
+        unmap_huge_pages(buffers.front().pointer, buffers.front().bytes);
+        buffers.erase(buffers.begin());
+    }
+
+    void clear() noexcept {
+        while (!buffers.empty()) {
+            pop_front();
+        }
+    }
+};
+
+thread_local thread_arena arena;
+
+}  // namespace
+
+void* allocate(std::size_t bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (!use_huge_pages(bytes)) {
+        void* pointer = std::aligned_alloc(cache_line_size, round_up(bytes, cache_line_size));
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+    arena.buffers.reserve(max_cached_buffers);
+    const unsigned node   = current_numa_node();
+    auto           cached = std::find_if(arena.buffers.begin(), arena.buffers.end(), [&](const cached_buffer& buffer) {
+        return buffer.bytes == bytes && buffer.node == node;
+    });
+    if (cached != arena.buffers.end()) {
+        void* pointer = cached->pointer;
+        arena.buffers.erase(cached);
+        cached_bytes -= bytes;
+        return pointer;
+    }
+    return map_huge_pages(bytes);
+}
+
+void deallocate(void* pointer, std::size_t bytes) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    if (!use_huge_pages(bytes)) {
+        std::free(pointer);
+        return;
+    }
+    if (arena.buffers.capacity() == 0 || bytes > max_cached_bytes) {
+        unmap_huge_pages(pointer, bytes);
+        return;
+    }
+    // Make room in the arena of this thread, oldest buffers first, then give up if the other threads hold the budget.
+    while (!arena.buffers.empty() && (arena.buffers.size() == arena.buffers.capacity() || cached_bytes + bytes > max_cached_bytes)) {
+        arena.pop_front();
+    }
+    if (cached_bytes.fetch_add(bytes) + bytes > max_cached_bytes) {
+        cached_bytes -= bytes;
+        unmap_huge_pages(pointer, bytes);
+        return;
+    }
+    arena.buffers.push_back({bytes, pointer, current_numa_node()});  // Within the reserved capacity: does not throw.
+}
+
+#if defined(__linux__)
+namespace {
+
+std::size_t page_size() {
+    static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+}  // namespace
+
+void* allocate_file_backed(std::size_t bytes, const std::string& directory) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    std::string path = directory + "/ising_spins_XXXXXX";
+    const int   fd   = mkstemp(path.data());
+    if (fd < 0) {
+        throw std::system_error(errno, std::generic_category(), "Cannot create a spin file in " + directory);
+    }
+    unlink(path.c_str());
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        const int error = errno;
+        close(fd);
+        throw std::system_error(error, std::generic_category(), "Cannot size the spin file in " + directory);
+    }
+    void* pointer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pointer == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void deallocate_file_backed(void* pointer, std::size_t bytes) noexcept {
+    if (pointer != nullptr) {
+        munmap(pointer, bytes);
+    }
+}
+
+void prefetch(const void* pointer, std::size_t bytes) noexcept {
+    // Widen the range to whole pages: reading ahead a page shared with the neighboring range is harmless.
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(pointer) / page_size() * page_size();
+    const std::uintptr_t end   = round_up(reinterpret_cast<std::uintptr_t>(pointer) + bytes, page_size());
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+void write_back(const void* pointer, std::size_t bytes) noexcept {
+    // Only the pages entirely inside the range are released, the ones shared with the neighboring ranges may be in use.
+    const std::uintptr_t begin = round_up(reinterpret_cast<std::uintptr_t>(pointer), page_size());
+    const std::uintptr_t end   = (reinterpret_cast<std::uintptr_t>(pointer) + bytes) / page_size() * page_size();
+    if (end <= begin) {
+        return;
+    }
+    void* const       address = reinterpret_cast<void*>(begin);
+    const std::size_t size    = end - begin;
+#ifdef MADV_PAGEOUT
+    // Write the dirty pages to the file and reclaim them right away (Linux 5.4+).
+    if (madvise(address, size, MADV_PAGEOUT) == 0) {
+        return;
+    }
+#endif
+    // Otherwise start the write-back and unmap the pages: the page cache drops them once they are clean.
+    msync(address, size, MS_ASYNC);
+    madvise(address, size, MADV_DONTNEED);
+}
+#else
+void* allocate_file_backed(std::size_t, const std::string&) {
+    throw std::runtime_error("File-backed spin storage is only available on Linux.");
+}
+
+void deallocate_file_backed(void*, std::size_t) noexcept {}
+void prefetch(const void*, std::size_t) noexcept {}
+void write_back(const void*, std::size_t) noexcept {}
+#endif
+
+void release_thread_cache() noexcept { arena.clear(); }
+
+bool pin_openmp_threads() {
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return false;
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    if (cpus.empty()) {
+        return false;
+    }
+    bool success = true;
+#pragma omp parallel reduction(&& : success)
+    {
+        int thread_id = 0;
+#ifdef _OPENMP
+        thread_id = omp_get_thread_num();
+#endif
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpus[thread_id % cpus.size()], &cpu_set);
+        success = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+    }
+    return success;
+#else
+    return false;
+#endif
+}
+
+}  // namespace spin_memory
@@ -0,0 +1,137 @@
+/**
+ * @file spin_allocator.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Allocator for the spin and scratch buffers: huge pages, per-thread reuse and no implicit first touch.
+ * @version 0.1
+ * @date 2022-09-22
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace spin_memory {
+
+constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+/**
+ * @brief Allocate a buffer of the given size.
+ *
+ * Buffers of at least one huge page are mapped with mmap, aligned on 2 MB and advised for transparent huge pages
+ * (explicit hugetlbfs pages are tried first when the ISING_HUGETLB environment variable is set). Smaller buffers come
+ * from aligned_alloc. Large buffers released by a thread that allocates large buffers itself are kept in a per-thread
+ * arena, tagged with the NUMA node the thread runs on, and handed back to its next allocation of the same size on the
+ * same node, so that consecutive jobs reuse memory that is already faulted in and local. Pinned threads
+ * (pin_openmp_threads()) never change node and always reuse their buffers. The arenas hold at most 256 MB in total.
+ *
+ * The memory is not touched: the first write decides on which NUMA node each page is placed.
+ */
+void* allocate(std::size_t bytes);
+void  deallocate(void* pointer, std::size_t bytes) noexcept;
+
+/**
+ * @brief Allocate a buffer in a memory-mapped file of the given directory, for arrays larger than the RAM.
+ *
+ * The file is created with a unique name and unlinked at once, so that it disappears with the mapping (and with the
+ * process). Its pages are read and written back by the kernel on demand, prefetch() and write_back() let a sweep
+ * stream through the buffer so that only the slabs in use stay resident.
+ */
+void* allocate_file_backed(std::size_t bytes, const std::string& directory);
+void  deallocate_file_backed(void* pointer, std::size_t bytes) noexcept;
+
+/**
+ * @brief Ask the kernel to read ahead the pages of a range of a file-backed buffer (MADV_WILLNEED).
+ */
+void prefetch(const void* pointer, std::size_t bytes) noexcept;
+
+/**
+ * @brief Write back the pages of a range of a file-backed buffer and release them from memory.
+ *
+ * The data stays in the file and is read again when next accessed. Must not be called on anonymous memory, whose
+ * content would be lost.
+ */
+void write_back(const void* pointer, std::size_t bytes) noexcept;
+
+/**
+ * @brief Return the buffers cached by the calling thread to the system.
+ */
+void release_thread_cache() noexcept;
+
+/**
+ * @brief Pin every thread of the OpenMP team to one CPU of the process affinity mask (round robin).
+ *
+ * @return true if all the threads could be pinned.
+ */
+bool pin_openmp_threads();
+
+}  // namespace spin_memory
+
+/**
+ * @brief Standard allocator over spin_memory::allocate, or over spin_memory::allocate_file_backed when constructed
+ * with a directory.
+ *
+ * Default construction of the elements is a default-initialization, so that resizing a vector does not write (and
+ * place) its pages: the lattices perform their own, parallel, first touch.
+ *
+ * The storage follows the container on copy (a copy of a file-backed vector gets its own file in the same directory),
+ * move and swap.
+ */
+template <typename T>
+struct spin_allocator {
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    std::shared_ptr<const std::string> m_directory;
+
+    spin_allocator() noexcept = default;
+    explicit spin_allocator(const std::string& directory)
+        : m_directory(directory.empty() ? nullptr : std::make_shared<const std::string>(directory)) {}
+    template <typename U>
+    spin_allocator(const spin_allocator<U>& other) noexcept : m_directory(other.m_directory) {}
+
+    bool is_file_backed() const noexcept { return m_directory != nullptr; }
+
+    T* allocate(std::size_t n) {
+        if (m_directory) {
+            return static_cast<T*>(spin_memory::allocate_file_backed(n * sizeof(T), *m_directory));
+        }
+        return static_cast<T*>(spin_memory::allocate(n * sizeof(T)));
+    }
+    void deallocate(T* pointer, std::size_t n) noexcept {
+        if (m_directory) {
+            spin_memory::deallocate_file_backed(pointer, n * sizeof(T));
+        } else {
+            spin_memory::deallocate(pointer, n * sizeof(T));
+        }
+    }
+
+    template <typename U>
+    void construct(U* pointer) noexcept(noexcept(::new (static_cast<void*>(pointer)) U)) {
+        ::new (static_cast<void*>(pointer)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* pointer, Args&&... args) {
+        ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    bool operator==(const spin_allocator<U>& other) const noexcept {
+        return m_directory == other.m_directory || (m_directory && other.m_directory && *m_directory == *other.m_directory);
+    }
+    template <typename U>
+    bool operator!=(const spin_allocator<U>& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+using spin_vector = std::vector<double, spin_allocator<double>>;
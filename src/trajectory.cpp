@@ -0,0 +1,261 @@
+/**
+ * @file trajectory.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Compact recording of the flip events of a simulation, with periodic keyframes, and exact replay.
+ * @version 0.1
+ * @date 2022-10-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "trajectory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace trajectory_format {
+
+void write_varint(std::vector<std::uint8_t>& buffer, std::uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(value));
+}
+
+std::uint64_t read_varint(const std::uint8_t*& position, const std::uint8_t* end) {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; position < end && shift < 64; shift += 7) {
+        const std::uint8_t byte = *position++;
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Corrupted trajectory: truncated varint");
+}
+
+}  // namespace trajectory_format
+
+namespace {
+
+/**
+ * @brief Read a varint directly from a stream, false at the end of the stream (or in the middle of the varint).
+ */
+bool read_varint(std::istream& stream, std::uint64_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        const int byte = stream.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+/**
+ * @brief Construct a new trajectory recorder::trajectory recorder object and write the initial keyframe (sweep 0).
+ *
+ * @param filename
+ * @param shape
+ * @param keyframe_interval Number of sweeps between two keyframes (at least 1).
+ * @param spins Current configuration of the lattice.
+ */
+trajectory_recorder::trajectory_recorder(const std::string&                filename,
+                                         const std::array<std::size_t, 3>& shape,
+                                         std::size_t                       keyframe_interval,
+                                         const double*                     spins)
+    : m_file(filename, std::ios::binary),
+      m_nb_spins(shape[0] * shape[1] * shape[2]),
+      m_keyframe_interval(std::max<std::size_t>(keyframe_interval, 1)),
+      m_thread_flips(1) {
+    if (!m_file) {
+        throw std::runtime_error("Cannot open the trajectory file " + filename);
+    }
+    m_file.write(trajectory_format::magic, 8);
+    for (std::size_t value : {shape[0], shape[1], shape[2], m_keyframe_interval}) {
+        trajectory_format::write_varint(m_buffer, value);
+    }
+    m_file.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+    write_keyframe(spins);
+}
+
+void trajectory_recorder::write_record(char type) {
+    std::vector<std::uint8_t> header;
+    header.push_back(static_cast<std::uint8_t>(type));
+    trajectory_format::write_varint(header, m_sweep);
+    trajectory_format::write_varint(header, m_buffer.size());
+    m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+    m_file.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+}
+
+void trajectory_recorder::write_keyframe(const double* spins) {
+    m_buffer.assign((m_nb_spins + 7) / 8, 0);
+    for (std::size_t index = 0; index < m_nb_spins; index++) {
+        if (spins[index] > 0.0) {
+            m_buffer[index / 8] |= static_cast<std::uint8_t>(1u << (index % 8));
+        }
+    }
+    write_record('K');
+    m_force_keyframe = false;
+}
+
+/**
+ * @brief Close the current sweep: write its keyframe, or the sites flipped an odd number of times since the previous
+ * record.
+ *
+ * @param spins Configuration at the end of the sweep.
+ */
+void trajectory_recorder::end_sweep(const double* spins) {
+    m_sweep++;
+    m_flips.clear();
+    for (auto& thread_flips : m_thread_flips) {
+        m_flips.insert(m_flips.end(), thread_flips.begin(), thread_flips.end());
+        thread_flips.clear();
+    }
+    if (m_force_keyframe || m_sweep % m_keyframe_interval == 0) {
+        write_keyframe(spins);
+        return;
+    }
+
+    std::sort(m_flips.begin(), m_flips.end());
+    std::size_t nb_changed = 0;
+    for (std::size_t begin = 0, end = 0; begin < m_flips.size(); begin = end) {
+        end = begin;
+        while (end < m_flips.size() && m_flips[end] == m_flips[begin]) {
+            end++;
+        }
+        if ((end - begin) % 2 == 1) {
+            m_flips[nb_changed++] = m_flips[begin];
+        }
+    }
+    m_buffer.clear();
+    trajectory_format::write_varint(m_buffer, nb_changed);
+    std::uint64_t previous = 0;
+    for (std::size_t index = 0; index < nb_changed; index++) {
+        trajectory_format::write_varint(m_buffer, m_flips[index] - previous);
+        previous = m_flips[index];
+    }
+    write_record('D');
+}
+
+/**
+ * @brief Construct a new trajectory reader::trajectory reader object and index the records of the file.
+ *
+ * @param filename
+ */
+trajectory_reader::trajectory_reader(const std::string& filename) : m_file(filename, std::ios::binary) {
+    char magic[8];
+    if (!m_file.read(magic, 8) || std::memcmp(magic, trajectory_format::magic, 8) != 0) {
+        throw std::runtime_error("Not a trajectory file: " + filename);
+    }
+    std::uint64_t header[4];
+    for (std::uint64_t& value : header) {
+        if (!read_varint(m_file, value)) {
+            throw std::runtime_error("Truncated trajectory header: " + filename);
+        }
+    }
+    m_shape             = {header[0], header[1], header[2]};
+    m_keyframe_interval = header[3];
+    m_spins.assign(m_shape[0] * m_shape[1] * m_shape[2], 1.0);
+
+    while (true) {
+        const int     type = m_file.get();
+        std::uint64_t sweep;
+        std::uint64_t size;
+        if (type == std::char_traits<char>::eof() || !read_varint(m_file, sweep) || !read_varint(m_file, size)) {
+            break;
+        }
+        if ((type != 'K' && type != 'D') || sweep != m_records.size()) {
+            break;
+        }
+        m_records.push_back({type == 'K', m_file.tellg(), static_cast<std::size_t>(size)});
+        m_file.seekg(static_cast<std::streamoff>(size), std::ios::cur);
+        if (!m_file) {
+            break;
+        }
+    }
+    m_file.clear();
+    // The payload of the last record may be missing if the writer was interrupted.
+    m_file.seekg(0, std::ios::end);
+    const std::streamoff file_size = m_file.tellg();
+    while (!m_records.empty() && m_records.back().offset + static_cast<std::streamoff>(m_records.back().size) > file_size) {
+        m_records.pop_back();
+    }
+    if (m_records.empty() || !m_records.front().keyframe) {
+        throw std::runtime_error("Trajectory without initial keyframe: " + filename);
+    }
+}
+
+/**
+ * @brief Apply the record of a sweep to the current configuration.
+ *
+ * @param sweep
+ */
+void trajectory_reader::apply(std::size_t sweep) {
+    const record_entry& record = m_records[sweep];
+    m_payload.resize(record.size);
+    m_file.seekg(record.offset);
+    m_file.read(reinterpret_cast<char*>(m_payload.data()), static_cast<std::streamsize>(record.size));
+    const std::uint8_t* position = m_payload.data();
+    const std::uint8_t* end      = m_payload.data() + m_payload.size();
+    if (record.keyframe) {
+        if (m_payload.size() != (m_spins.size() + 7) / 8) {
+            throw std::runtime_error("Corrupted trajectory: keyframe size");
+        }
+        for (std::size_t index = 0; index < m_spins.size(); index++) {
+            m_spins[index] = (m_payload[index / 8] >> (index % 8)) & 1u ? 1.0 : -1.0;
+        }
+    } else {
+        const std::uint64_t nb_changed = trajectory_format::read_varint(position, end);
+        std::uint64_t       index      = 0;
+        for (std::uint64_t change = 0; change < nb_changed; change++) {
+            index += trajectory_format::read_varint(position, end);
+            if (index >= m_spins.size()) {
+                throw std::runtime_error("Corrupted trajectory: site index out of the lattice");
+            }
+            m_spins[index] = -m_spins[index];
+        }
+    }
+    m_sweep = sweep;
+    m_valid = true;
+}
+
+const std::vector<double>& trajectory_reader::seek(std::size_t sweep) {
+    if (sweep >= m_records.size()) {
+        throw std::out_of_range("Sweep " + std::to_string(sweep) + " is not in the trajectory (" + std::to_string(m_records.size()) + " sweeps)");
+    }
+    std::size_t keyframe = sweep;
+    while (!m_records[keyframe].keyframe) {
+        keyframe--;
+    }
+    // Replay from the current configuration when it is between the keyframe and the target.
+    std::size_t start = keyframe;
+    if (m_valid && m_sweep >= keyframe && m_sweep <= sweep) {
+        start = m_sweep + 1;
+    } else {
+        apply(keyframe);
+        start = keyframe + 1;
+    }
+    for (std::size_t current = start; current <= sweep; current++) {
+        apply(current);
+    }
+    return m_spins;
+}
+
+bool trajectory_reader::next() {
+    const std::size_t sweep = m_valid ? m_sweep + 1 : 0;
+    if (sweep >= m_records.size()) {
+        return false;
+    }
+    seek(sweep);
+    return true;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file trajectory.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Compact recording of the flip events of a simulation, with periodic keyframes, and exact replay.
+ * @version 0.1
+ * @date 2022-10-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Trajectory file format (all integers are unsigned LEB128 varints unless stated otherwise).
+ *
+ * - Header: the 8 bytes "ISTRAJ1\n", then size_x, size_y, size_z and the keyframe interval.
+ * - One record per sweep, sweep 0 being the configuration when the recording started: a type byte ('K' or 'D'), the
+ *   sweep index, the payload size in bytes, then the payload.
+ * - Keyframe ('K') payload: the spins bit-packed in storage order (x fastest), bit i % 8 of byte i / 8 set for +1.
+ * - Delta ('D') payload: the number of sites whose spin changed during the sweep, then their sorted linear indices as
+ *   gaps (the first index, then the difference with the previous one).
+ *
+ * A site flipped an even number of times in a sweep is not stored: a delta record is the XOR between two consecutive
+ * configurations, so its size scales with the number of changed spins and not with the lattice size.
+ */
+namespace trajectory_format {
+
+constexpr char magic[9] = "ISTRAJ1\n";
+
+void          write_varint(std::vector<std::uint8_t>& buffer, std::uint64_t value);
+std::uint64_t read_varint(const std::uint8_t*& position, const std::uint8_t* end);
+
+}  // namespace trajectory_format
+
+/**
+ * @brief Writer of a trajectory file, fed with the flips of a lattice.
+ *
+ * record_flip() is called for each accepted flip, from any thread of the team of a parallel sweep (each thread has its
+ * own buffer), and end_sweep() once the sweep is over. A keyframe is written every keyframe_interval sweeps, and at the
+ * next sweep after invalidate() (the spins were overwritten without flips).
+ */
+class trajectory_recorder {
+ private:
+    std::ofstream                           m_file;
+    std::size_t                             m_nb_spins;
+    std::size_t                             m_keyframe_interval;
+    std::size_t                             m_sweep           = 0;
+    bool                                    m_force_keyframe  = false;
+    std::vector<std::vector<std::uint64_t>> m_thread_flips;
+    std::vector<std::uint64_t>              m_flips;
+    std::vector<std::uint8_t>               m_buffer;
+
+    void write_record(char type);
+    void write_keyframe(const double* spins);
+
+ public:
+    trajectory_recorder(const std::string& filename, const std::array<std::size_t, 3>& shape, std::size_t keyframe_interval, const double* spins);
+
+    /**
+     * @brief Give one flip buffer to each of the nb_threads threads of the next parallel sweep.
+     */
+    void prepare_threads(std::size_t nb_threads) {
+        if (m_thread_flips.size() < nb_threads) {
+            m_thread_flips.resize(nb_threads);
+        }
+    }
+
+    /**
+     * @brief Record a flip of the spin at index, in the buffer of the calling thread.
+     *
+     * Outside of a parallel sweep, the calling thread may be a thread of an enclosing team (one lattice per thread),
+     * whose buffer is then created on the fly.
+     */
+    void record_flip(std::size_t thread, std::size_t index) {
+        if (thread >= m_thread_flips.size()) {
+            m_thread_flips.resize(thread + 1);
+        }
+        m_thread_flips[thread].push_back(index);
+    }
+
+    void invalidate() { m_force_keyframe = true; }
+    void end_sweep(const double* spins);
+
+    std::size_t get_number_sweeps() const { return m_sweep + 1; }
+};
+
+/**
+ * @brief Recorder of a lattice: a copy of the lattice (clone()) starts without recorder, so that its sweeps never end
+ * up in the trajectory of the original.
+ */
+class trajectory_slot {
+ private:
+    std::unique_ptr<trajectory_recorder> m_recorder;
+
+ public:
+    trajectory_slot() = default;
+    trajectory_slot(const trajectory_slot&) noexcept {}
+    trajectory_slot& operator=(const trajectory_slot&) noexcept {
+        m_recorder.reset();
+        return *this;
+    }
+    trajectory_slot(trajectory_slot&&) noexcept            = default;
+    trajectory_slot& operator=(trajectory_slot&&) noexcept = default;
+
+    void                 reset(std::unique_ptr<trajectory_recorder> recorder = nullptr) { m_recorder = std::move(recorder); }
+    trajectory_recorder* operator->() const { return m_recorder.get(); }
+    explicit             operator bool() const { return m_recorder != nullptr; }
+};
+
+/**
+ * @brief Random access replay of a trajectory file.
+ *
+ * The file is indexed once at construction (only the record headers are read). seek() rebuilds the configuration of
+ * any sweep from the last keyframe before it, or from the current configuration when moving forward without crossing
+ * a keyframe, so that replaying the sweeps in order with next() applies each delta once. A truncated last record (the
+ * simulation was interrupted) is ignored.
+ */
+class trajectory_reader {
+ private:
+    struct record_entry {
+        bool           keyframe;
+        std::streamoff offset;
+        std::size_t    size;
+    };
+
+    std::ifstream              m_file;
+    std::array<std::size_t, 3> m_shape;
+    std::size_t                m_keyframe_interval = 0;
+    std::vector<record_entry>  m_records;
+    std::vector<double>        m_spins;
+    std::size_t                m_sweep = 0;
+    bool                       m_valid = false;
+    std::vector<std::uint8_t>  m_payload;
+
+    void apply(std::size_t sweep);
+
+ public:
+    explicit trajectory_reader(const std::string& filename);
+
+    std::array<std::size_t, 3> get_shape() const { return m_shape; }
+    std::size_t                get_keyframe_interval() const { return m_keyframe_interval; }
+    std::size_t                get_number_sweeps() const { return m_records.size(); }
+
+    /**
+     * @brief Configuration after the given sweep (0: when the recording started), in the storage order of the lattice.
+     */
+    const std::vector<double>& seek(std::size_t sweep);
+
+    /**
+     * @brief Move to the next sweep (the first one if nothing was read yet), false at the end of the trajectory.
+     */
+    bool next();
+
+    std::size_t                get_sweep() const { return m_sweep; }
+    const std::vector<double>& get_spins() const { return m_spins; }
+};
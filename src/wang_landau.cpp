@@ -0,0 +1,643 @@
+/**
+ * @file wang_landau.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Replica-exchange Wang-Landau estimation of the density of states.
+ * @version 0.1
+ * @date 2022-09-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include "wang_landau.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+void write_histogram(std::ostream& stream, const energy_histogram& histogram) {
+    stream << histogram.size();
+    for (const auto& [key, value] : histogram.bins()) {
+        stream << " " << key << " " << value;
+    }
+    stream << "\n";
+}
+
+void read_histogram(std::istream& stream, energy_histogram& histogram) {
+    std::size_t size = 0;
+    stream >> size;
+    histogram.clear();
+    for (std::size_t index = 0; index < size; index++) {
+        std::int64_t key   = 0;
+        double       value = 0.0;
+        stream >> key >> value;
+        histogram.bins()[key] = value;
+    }
+}
+
+double log_sum_exp(const energy_histogram& histogram) {
+    double max_value = -std::numeric_limits<double>::infinity();
+    for (const auto& [key, value] : histogram.bins()) {
+        max_value = std::max(max_value, value);
+    }
+    double sum = 0.0;
+    for (const auto& [key, value] : histogram.bins()) {
+        sum += std::exp(value - max_value);
+    }
+    return max_value + std::log(sum);
+}
+
+}  // namespace
+
+/**
+ * @brief Value stored for the level of the given energy, 0 if the level was never visited.
+ *
+ * @param energy
+ * @return double
+ */
+double energy_histogram::get(double energy) const {
+    auto it = m_bins.find(key(energy));
+    return it == m_bins.end() ? 0.0 : it->second;
+}
+
+/**
+ * @brief Construct a new wang landau::wang landau object.
+ *
+ * @param prototype Lattice (shape, couplings) whose density of states is estimated. It is copied for every walker.
+ * @param parameters
+ */
+wang_landau::wang_landau(const ising_base& prototype, const wang_landau_parameters& parameters)
+    : m_prototype(prototype.clone()),
+      m_parameters(parameters),
+      m_random_engine(std::random_device{}()),
+      m_ln_g(parameters.energy_resolution),
+      m_mean_abs_magnetization(parameters.energy_resolution),
+      m_mean_square_magnetization(parameters.energy_resolution) {}
+
+/**
+ * @brief Estimate the reachable energy range.
+ *
+ * The lower bound is the fully magnetized (ground) state. The upper bound is the best of a few annealed ascents: a
+ * Metropolis run at negative temperature, cooled towards zero, followed by a greedy ascent. A single greedy ascent from
+ * a random configuration gets stuck in local maxima (e.g. antiferromagnetic domains separated by walls), which would
+ * leave the highest levels out of g(E).
+ *
+ * @param energy_min
+ * @param energy_max
+ */
+void wang_landau::estimate_energy_range(double& energy_min, double& energy_max) {
+    auto        lattice  = m_prototype->clone();
+    std::size_t nb_spins = lattice->get_number_spins();
+    lattice->set_spins(std::vector<double>(nb_spins, 1.0));
+    energy_min = compute_energy(*lattice);
+
+    const double                     tolerance             = 0.5 * m_parameters.energy_resolution;
+    const std::size_t                nb_ascents            = 4;
+    const std::size_t                nb_annealing_sweeps   = 200;
+    const double                     initial_temperature   = 5.0;
+    const double                     final_temperature     = 0.05;
+    const std::size_t                max_passes            = 1000;
+    std::uniform_real_distribution<> double_distribution(0.0, 1.0);
+    energy_max = -std::numeric_limits<double>::infinity();
+    for (std::size_t ascent = 0; ascent < nb_ascents; ascent++) {
+        lattice->set_seed(m_random_engine());
+        lattice->initialize_random(0.5);
+        for (std::size_t sweep = 0; sweep < nb_annealing_sweeps; sweep++) {
+            const double temperature =
+                initial_temperature * std::pow(final_temperature / initial_temperature, static_cast<double>(sweep) / (nb_annealing_sweeps - 1));
+            for (std::size_t index = 0; index < nb_spins; index++) {
+                const double delta_energy = lattice->compute_flip_delta_energy(index);
+                if (delta_energy >= 0.0 || double_distribution(m_random_engine) < std::exp(delta_energy / temperature)) {
+                    lattice->flip_spin_at(index);
+                }
+            }
+        }
+        for (std::size_t pass = 0; pass < max_passes; pass++) {
+            std::size_t nb_flips = 0;
+            for (std::size_t index = 0; index < nb_spins; index++) {
+                if (lattice->compute_flip_delta_energy(index) > tolerance) {
+                    lattice->flip_spin_at(index);
+                    nb_flips++;
+                }
+            }
+            if (nb_flips == 0) {
+                break;
+            }
+        }
+        energy_max = std::max(energy_max, compute_energy(*lattice));
+    }
+}
+
+/**
+ * @brief Split the estimated energy range into windows and place the walkers.
+ *
+ */
+void wang_landau::initialize() {
+    double energy_min = 0.0;
+    double energy_max = 0.0;
+    estimate_energy_range(energy_min, energy_max);
+    initialize(energy_min, energy_max);
+}
+
+/**
+ * @brief Split [energy_min, energy_max] into overlapping windows and place the walkers inside their window.
+ *
+ * @param energy_min
+ * @param energy_max
+ */
+void wang_landau::initialize(double energy_min, double energy_max) {
+    const std::size_t nb_windows = std::max<std::size_t>(1, m_parameters.nb_windows);
+    const double      step       = 1.0 - m_parameters.window_overlap;
+    const double      width      = (energy_max - energy_min) / (1.0 + (nb_windows - 1) * step);
+
+    m_windows.clear();
+    for (std::size_t index_window = 0; index_window < nb_windows; index_window++) {
+        const double lower = energy_min + index_window * width * step;
+        const double upper = (index_window + 1 == nb_windows) ? energy_max : lower + width;
+        m_windows.push_back({lower, upper, m_parameters.ln_f_initial});
+    }
+
+    const double resolution = m_parameters.energy_resolution;
+    m_walkers.clear();
+    m_number_rounds = 0;
+    for (std::size_t index_window = 0; index_window < nb_windows; index_window++) {
+        for (std::size_t index_walker = 0; index_walker < m_parameters.walkers_per_window; index_walker++) {
+            walker new_walker{m_prototype->clone(),
+                              std::mt19937(m_random_engine()),
+                              index_window,
+                              0.0,
+                              0.0,
+                              energy_histogram(resolution),
+                              energy_histogram(resolution),
+                              energy_histogram(resolution),
+                              energy_histogram(resolution),
+                              energy_histogram(resolution)};
+            new_walker.lattice->set_spins(std::vector<double>(new_walker.lattice->get_number_spins(), 1.0));
+            new_walker.energy        = compute_energy(*new_walker.lattice);
+            new_walker.magnetization = static_cast<double>(new_walker.lattice->get_number_spins());
+            m_walkers.push_back(std::move(new_walker));
+        }
+    }
+#pragma omp parallel for schedule(dynamic)
+    for (std::size_t index_walker = 0; index_walker < m_walkers.size(); index_walker++) {
+        drive_into_window(m_walkers[index_walker]);
+    }
+}
+
+/**
+ * @brief Greedy walk from the ground state until the walker energy lies inside its window.
+ *
+ * @param current_walker
+ */
+void wang_landau::drive_into_window(walker& current_walker) {
+    const energy_window& window    = m_windows[current_walker.window];
+    const double         target    = 0.5 * (window.lower + window.upper);
+    const double         tolerance = 0.5 * m_parameters.energy_resolution;
+    ising_base&          lattice   = *current_walker.lattice;
+    const std::size_t    nb_spins  = lattice.get_number_spins();
+
+    std::uniform_int_distribution<std::size_t> site_distribution(0, nb_spins - 1);
+    const std::size_t                          max_moves = 1000 * nb_spins;
+    for (std::size_t move = 0; move < max_moves; move++) {
+        if (current_walker.energy >= window.lower - tolerance && current_walker.energy <= window.upper + tolerance) {
+            return;
+        }
+        const std::size_t index        = site_distribution(current_walker.random_engine);
+        const double      delta_energy = lattice.compute_flip_delta_energy(index);
+        if (std::abs(current_walker.energy + delta_energy - target) <= std::abs(current_walker.energy - target)) {
+            current_walker.magnetization -= 2.0 * lattice.get_spin_at(index);
+            current_walker.energy += delta_energy;
+            lattice.flip_spin_at(index);
+        }
+    }
+    throw std::runtime_error("Wang-Landau: unable to drive a walker into the energy window [" + std::to_string(window.lower) + ", " +
+                             std::to_string(window.upper) + "]");
+}
+
+/**
+ * @brief Perform nb_sweeps * N Wang-Landau moves restricted to the walker window.
+ *
+ * @param current_walker
+ * @param nb_sweeps
+ */
+void wang_landau::walker_sweeps(walker& current_walker, std::size_t nb_sweeps) {
+    const energy_window& window    = m_windows[current_walker.window];
+    const double         tolerance = 0.5 * m_parameters.energy_resolution;
+    ising_base&          lattice   = *current_walker.lattice;
+    const std::size_t    nb_spins  = lattice.get_number_spins();
+
+    std::uniform_int_distribution<std::size_t> site_distribution(0, nb_spins - 1);
+    std::uniform_real_distribution<double>     double_distribution(0.0, 1.0);
+    for (std::size_t move = 0; move < nb_sweeps * nb_spins; move++) {
+        const std::size_t index      = site_distribution(current_walker.random_engine);
+        const double      new_energy = current_walker.energy + lattice.compute_flip_delta_energy(index);
+        if (new_energy >= window.lower - tolerance && new_energy <= window.upper + tolerance) {
+            const double ln_ratio = current_walker.ln_g.get(current_walker.energy) - current_walker.ln_g.get(new_energy);
+            if (ln_ratio >= 0.0 || double_distribution(current_walker.random_engine) < std::exp(ln_ratio)) {
+                current_walker.magnetization -= 2.0 * lattice.get_spin_at(index);
+                current_walker.energy = new_energy;
+                lattice.flip_spin_at(index);
+            }
+        }
+        current_walker.ln_g.add(current_walker.energy, window.ln_f);
+        current_walker.histogram.add(current_walker.energy, 1.0);
+        current_walker.sum_abs_magnetization.add(current_walker.energy, std::abs(current_walker.magnetization));
+        current_walker.sum_square_magnetization.add(current_walker.energy, current_walker.magnetization * current_walker.magnetization);
+        current_walker.nb_samples.add(current_walker.energy, 1.0);
+    }
+}
+
+/**
+ * @brief Propose configuration exchanges between walkers of neighboring windows.
+ *
+ * Even and odd window pairs alternate from one round to the next.
+ */
+void wang_landau::replica_exchange() {
+    const std::size_t                      walkers_per_window = m_parameters.walkers_per_window;
+    const double                           tolerance          = 0.5 * m_parameters.energy_resolution;
+    std::uniform_real_distribution<double> double_distribution(0.0, 1.0);
+    for (std::size_t index_window = m_number_rounds % 2; index_window + 1 < m_windows.size(); index_window += 2) {
+        const energy_window& lower_window = m_windows[index_window];
+        const energy_window& upper_window = m_windows[index_window + 1];
+        for (std::size_t index_walker = 0; index_walker < walkers_per_window; index_walker++) {
+            walker& walker_a = m_walkers[index_window * walkers_per_window + index_walker];
+            walker& walker_b = m_walkers[(index_window + 1) * walkers_per_window + index_walker];
+            if (walker_a.energy < upper_window.lower - tolerance || walker_b.energy > lower_window.upper + tolerance) {
+                continue;
+            }
+            if (!walker_a.ln_g.contains(walker_b.energy) || !walker_b.ln_g.contains(walker_a.energy)) {
+                continue;
+            }
+            const double ln_ratio = walker_a.ln_g.get(walker_a.energy) - walker_a.ln_g.get(walker_b.energy) +
+                                    walker_b.ln_g.get(walker_b.energy) - walker_b.ln_g.get(walker_a.energy);
+            if (ln_ratio >= 0.0 || double_distribution(m_random_engine) < std::exp(ln_ratio)) {
+                std::swap(walker_a.lattice, walker_b.lattice);
+                std::swap(walker_a.energy, walker_b.energy);
+                std::swap(walker_a.magnetization, walker_b.magnetization);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Average of ln g(E) over the walkers of a window.
+ *
+ * @param index_window
+ * @return energy_histogram
+ */
+energy_histogram wang_landau::average_ln_g(std::size_t index_window) const {
+    energy_histogram sum(m_parameters.energy_resolution);
+    energy_histogram count(m_parameters.energy_resolution);
+    for (const walker& current_walker : m_walkers) {
+        if (current_walker.window != index_window) {
+            continue;
+        }
+        for (const auto& [key, value] : current_walker.ln_g.bins()) {
+            sum.bins()[key] += value;
+            count.bins()[key] += 1.0;
+        }
+    }
+    for (auto& [key, value] : sum.bins()) {
+        value /= count.bins()[key];
+    }
+    return sum;
+}
+
+/**
+ * @brief Reduce the modification factor of the windows whose walkers all have a flat histogram.
+ *
+ * The flatness is measured over every level visited since the beginning of the run (the keys of ln g).
+ */
+void wang_landau::update_modification_factors() {
+    for (std::size_t index_window = 0; index_window < m_windows.size(); index_window++) {
+        energy_window& window = m_windows[index_window];
+        if (window.ln_f <= m_parameters.ln_f_final) {
+            continue;
+        }
+        bool all_flat = true;
+        for (const walker& current_walker : m_walkers) {
+            if (current_walker.window != index_window) {
+                continue;
+            }
+            const auto& levels = current_walker.ln_g.bins();
+            if (levels.empty()) {
+                all_flat = false;
+                break;
+            }
+            double sum_histogram = 0.0;
+            double min_histogram = std::numeric_limits<double>::max();
+            for (const auto& [key, value] : levels) {
+                auto   it    = current_walker.histogram.bins().find(key);
+                double count = it == current_walker.histogram.bins().end() ? 0.0 : it->second;
+                sum_histogram += count;
+                min_histogram = std::min(min_histogram, count);
+            }
+            if (min_histogram < m_parameters.flatness * sum_histogram / levels.size()) {
+                all_flat = false;
+                break;
+            }
+        }
+        if (!all_flat) {
+            continue;
+        }
+        const energy_histogram merged_ln_g = average_ln_g(index_window);
+        for (walker& current_walker : m_walkers) {
+            if (current_walker.window == index_window) {
+                current_walker.ln_g = merged_ln_g;
+                current_walker.histogram.clear();
+            }
+        }
+        window.ln_f /= 2.0;
+    }
+}
+
+/**
+ * @brief Check that every window reached the final modification factor.
+ *
+ * @return true
+ * @return false
+ */
+bool wang_landau::is_converged() const {
+    return !m_windows.empty() &&
+           std::all_of(m_windows.begin(), m_windows.end(), [&](const energy_window& window) { return window.ln_f <= m_parameters.ln_f_final; });
+}
+
+/**
+ * @brief Run the walkers until every window converged, then build the global density of states.
+ *
+ */
+void wang_landau::run() {
+    if (m_walkers.empty()) {
+        initialize();
+    }
+    while (!is_converged()) {
+#pragma omp parallel for schedule(dynamic)
+        for (std::size_t index_walker = 0; index_walker < m_walkers.size(); index_walker++) {
+            walker_sweeps(m_walkers[index_walker], m_parameters.sweeps_between_checks);
+        }
+        // Remove the round-off accumulated by the incremental energy updates.
+        for (walker& current_walker : m_walkers) {
+            current_walker.energy = compute_energy(*current_walker.lattice);
+        }
+        replica_exchange();
+        update_modification_factors();
+        m_number_rounds++;
+        if (!m_parameters.checkpoint_file.empty() && m_number_rounds % m_parameters.checkpoint_interval == 0) {
+            save_checkpoint(m_parameters.checkpoint_file);
+        }
+    }
+    if (!m_parameters.checkpoint_file.empty()) {
+        save_checkpoint(m_parameters.checkpoint_file);
+    }
+    stitch_windows();
+}
+
+/**
+ * @brief Join the window estimates into the global ln g(E) and normalize it.
+ *
+ * Two consecutive windows are joined at the common level where their slopes d ln g / dE agree best. The result is
+ * normalized such that the sum of g(E) over all levels is 2^N.
+ */
+void wang_landau::stitch_windows() {
+    m_ln_g = average_ln_g(0);
+    for (std::size_t index_window = 1; index_window < m_windows.size(); index_window++) {
+        const energy_histogram window_ln_g = average_ln_g(index_window);
+        auto&                  total       = m_ln_g.bins();
+        const auto&            current     = window_ln_g.bins();
+
+        std::int64_t best_key        = 0;
+        double       best_difference = std::numeric_limits<double>::infinity();
+        for (auto it = current.begin(); it != current.end(); ++it) {
+            auto it_total = total.find(it->first);
+            if (it_total == total.end()) {
+                continue;
+            }
+            auto next_current = std::next(it);
+            auto next_total   = std::next(it_total);
+            if (next_current == current.end() || next_total == total.end()) {
+                continue;
+            }
+            const double slope_current = (next_current->second - it->second) / static_cast<double>(next_current->first - it->first);
+            const double slope_total   = (next_total->second - it_total->second) / static_cast<double>(next_total->first - it_total->first);
+            const double difference    = std::abs(slope_current - slope_total);
+            if (difference < best_difference) {
+                best_difference = difference;
+                best_key        = it->first;
+            }
+        }
+        if (!std::isfinite(best_difference)) {
+            throw std::runtime_error("Wang-Landau: windows " + std::to_string(index_window - 1) + " and " + std::to_string(index_window) +
+                                     " have no common energy levels, increase the window overlap.");
+        }
+        const double shift = total[best_key] - current.at(best_key);
+        total.erase(total.upper_bound(best_key), total.end());
+        for (auto it = current.upper_bound(best_key); it != current.end(); ++it) {
+            total[it->first] = it->second + shift;
+        }
+    }
+
+    const double nb_spins      = static_cast<double>(m_prototype->get_number_spins());
+    const double normalization = nb_spins * std::log(2.0) - log_sum_exp(m_ln_g);
+    for (auto& [key, value] : m_ln_g.bins()) {
+        value += normalization;
+    }
+
+    energy_histogram sum_abs(m_parameters.energy_resolution);
+    energy_histogram sum_square(m_parameters.energy_resolution);
+    energy_histogram nb_samples(m_parameters.energy_resolution);
+    for (const walker& current_walker : m_walkers) {
+        for (const auto& [key, value] : current_walker.sum_abs_magnetization.bins()) {
+            sum_abs.bins()[key] += value;
+        }
+        for (const auto& [key, value] : current_walker.sum_square_magnetization.bins()) {
+            sum_square.bins()[key] += value;
+        }
+        for (const auto& [key, value] : current_walker.nb_samples.bins()) {
+            nb_samples.bins()[key] += value;
+        }
+    }
+    m_mean_abs_magnetization.clear();
+    m_mean_square_magnetization.clear();
+    for (const auto& [key, count] : nb_samples.bins()) {
+        m_mean_abs_magnetization.bins()[key]    = sum_abs.bins()[key] / count;
+        m_mean_square_magnetization.bins()[key] = sum_square.bins()[key] / count;
+    }
+}
+
+/**
+ * @brief Canonical averages at the given temperature, derived from the density of states.
+ *
+ * All the quantities are given per spin: mean energy, mean absolute magnetization,
+ * specific heat (<E^2> - <E>^2) / (N T^2) and susceptibility (<M^2> - <|M|>^2) / (N T).
+ *
+ * @param temperature
+ * @return ising_result
+ */
+ising_result wang_landau::compute_thermodynamics(double temperature) const {
+    double max_ln_weight = -std::numeric_limits<double>::infinity();
+    for (const auto& [key, ln_g] : m_ln_g.bins()) {
+        max_ln_weight = std::max(max_ln_weight, ln_g - m_ln_g.energy(key) / temperature);
+    }
+    double partition_function = 0.0;
+    double sum_energy         = 0.0;
+    double sum_square_energy  = 0.0;
+    double sum_abs_magnet     = 0.0;
+    double sum_square_magnet  = 0.0;
+    for (const auto& [key, ln_g] : m_ln_g.bins()) {
+        const double energy = m_ln_g.energy(key);
+        const double weight = std::exp(ln_g - energy / temperature - max_ln_weight);
+        partition_function += weight;
+        sum_energy += weight * energy;
+        sum_square_energy += weight * energy * energy;
+        auto it_abs    = m_mean_abs_magnetization.bins().find(key);
+        auto it_square = m_mean_square_magnetization.bins().find(key);
+        if (it_abs != m_mean_abs_magnetization.bins().end()) {
+            sum_abs_magnet += weight * it_abs->second;
+            sum_square_magnet += weight * it_square->second;
+        }
+    }
+    const double nb_spins          = static_cast<double>(m_prototype->get_number_spins());
+    const double mean_energy       = sum_energy / partition_function;
+    const double mean_square       = sum_square_energy / partition_function;
+    const double mean_abs_magnet   = sum_abs_magnet / partition_function;
+    const double mean_square_mag   = sum_square_magnet / partition_function;
+    ising_result result{mean_energy / nb_spins,
+                        mean_abs_magnet / nb_spins,
+                        (mean_square - mean_energy * mean_energy) / (nb_spins * temperature * temperature),
+                        (mean_square_mag - mean_abs_magnet * mean_abs_magnet) / (nb_spins * temperature)};
+    return result;
+}
+
+/**
+ * @brief Export ln g(E) and the microcanonical magnetization averages to a CSV file.
+ *
+ * @param filename
+ */
+void wang_landau::export_density_of_states(const std::string& filename) const {
+    std::ofstream file(filename);
+    file << std::setprecision(17);
+    file << "energy,ln_g,mean_abs_magnetization,mean_square_magnetization\n";
+    for (const auto& [key, ln_g] : m_ln_g.bins()) {
+        file << m_ln_g.energy(key) << "," << ln_g << "," << m_mean_abs_magnetization.get(m_ln_g.energy(key)) << ","
+             << m_mean_square_magnetization.get(m_ln_g.energy(key)) << "\n";
+    }
+}
+
+/**
+ * @brief Save the complete sampler state (windows, walkers configurations, histograms and random engines, including
+ * the one of the replica exchanges and walker seeding).
+ *
+ * The file is first written to a temporary path and then renamed, so that an interrupted run never leaves a
+ * truncated checkpoint behind.
+ *
+ * @param filename
+ */
+void wang_landau::save_checkpoint(const std::string& filename) const {
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream file(tmp_filename);
+        file << std::setprecision(17);
+        file << "wang_landau_checkpoint 1\n";
+        file << "nb_spins " << m_prototype->get_number_spins() << "\n";
+        file << "resolution " << m_parameters.energy_resolution << "\n";
+        file << "walkers_per_window " << m_parameters.walkers_per_window << "\n";
+        file << "rounds " << m_number_rounds << "\n";
+        file << "random_engine " << m_random_engine << "\n";
+        file << "windows " << m_windows.size() << "\n";
+        for (const energy_window& window : m_windows) {
+            file << window.lower << " " << window.upper << " " << window.ln_f << "\n";
+        }
+        file << "walkers " << m_walkers.size() << "\n";
+        for (const walker& current_walker : m_walkers) {
+            file << current_walker.window << " " << current_walker.energy << " " << current_walker.magnetization << "\n";
+            file << current_walker.random_engine << "\n";
+            write_histogram(file, current_walker.ln_g);
+            write_histogram(file, current_walker.histogram);
+            write_histogram(file, current_walker.sum_abs_magnetization);
+            write_histogram(file, current_walker.sum_square_magnetization);
+            write_histogram(file, current_walker.nb_samples);
+            for (double spin : current_walker.lattice->get_spins()) {
+                file << (spin > 0.0 ? '+' : '-');
+            }
+            file << "\n";
+        }
+    }
+    std::rename(tmp_filename.c_str(), filename.c_str());
+}
+
+/**
+ * @brief Restore the sampler state saved by save_checkpoint(). The prototype lattice must have the same shape.
+ *
+ * @param filename
+ */
+void wang_landau::load_checkpoint(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Wang-Landau: unable to open checkpoint " + filename);
+    }
+    std::string keyword;
+    int         version = 0;
+    file >> keyword >> version;
+    if (keyword != "wang_landau_checkpoint" || version != 1) {
+        throw std::runtime_error("Wang-Landau: " + filename + " is not a valid checkpoint");
+    }
+    std::size_t nb_spins   = 0;
+    std::size_t nb_windows = 0;
+    std::size_t nb_walkers = 0;
+    file >> keyword >> nb_spins;
+    if (nb_spins != m_prototype->get_number_spins()) {
+        throw std::runtime_error("Wang-Landau: checkpoint lattice size does not match the prototype lattice");
+    }
+    file >> keyword >> m_parameters.energy_resolution;
+    file >> keyword >> m_parameters.walkers_per_window;
+    file >> keyword >> m_number_rounds;
+    file >> keyword >> m_random_engine;
+    file >> keyword >> nb_windows;
+    m_windows.resize(nb_windows);
+    for (energy_window& window : m_windows) {
+        file >> window.lower >> window.upper >> window.ln_f;
+    }
+    m_parameters.nb_windows = nb_windows;
+
+    const double resolution = m_parameters.energy_resolution;
+    file >> keyword >> nb_walkers;
+    m_walkers.clear();
+    for (std::size_t index_walker = 0; index_walker < nb_walkers; index_walker++) {
+        walker new_walker{m_prototype->clone(),
+                          std::mt19937(),
+                          0,
+                          0.0,
+                          0.0,
+                          energy_histogram(resolution),
+                          energy_histogram(resolution),
+                          energy_histogram(resolution),
+                          energy_histogram(resolution),
+                          energy_histogram(resolution)};
+        file >> new_walker.window >> new_walker.energy >> new_walker.magnetization;
+        file >> new_walker.random_engine;
+        read_histogram(file, new_walker.ln_g);
+        read_histogram(file, new_walker.histogram);
+        read_histogram(file, new_walker.sum_abs_magnetization);
+        read_histogram(file, new_walker.sum_square_magnetization);
+        read_histogram(file, new_walker.nb_samples);
+        std::string encoded_spins;
+        file >> encoded_spins;
+        if (encoded_spins.size() != nb_spins) {
+            throw std::runtime_error("Wang-Landau: corrupted spin configuration in checkpoint " + filename);
+        }
+        std::vector<double> spins(nb_spins);
+        std::transform(encoded_spins.begin(), encoded_spins.end(), spins.begin(), [](char c) { return c == '+' ? 1.0 : -1.0; });
+        new_walker.lattice->set_spins(spins);
+        m_walkers.push_back(std::move(new_walker));
+    }
+    if (!file) {
+        throw std::runtime_error("Wang-Landau: truncated checkpoint " + filename);
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * @file wang_landau.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Replica-exchange Wang-Landau estimation of the density of states.
+ * @version 0.1
+ * @date 2022-09-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ising_base.hpp"
+
+/**
+ * @brief Sparse histogram over energy levels.
+ *
+ * Energies are quantized with a fixed resolution and stored in an ordered map, so that the (possibly very sparse)
+ * set of levels produced by anisotropic couplings only costs memory for the levels actually visited.
+ */
+class energy_histogram {
+ private:
+    double                          m_resolution;
+    std::map<std::int64_t, double> m_bins;
+
+ public:
+    explicit energy_histogram(double resolution = 1.0e-6) : m_resolution(resolution) {}
+
+    std::int64_t key(double energy) const { return std::llround(energy / m_resolution); }
+    double       energy(std::int64_t key) const { return static_cast<double>(key) * m_resolution; }
+    double       get_resolution() const { return m_resolution; }
+
+    bool   contains(double energy) const { return m_bins.find(key(energy)) != m_bins.end(); }
+    double get(double energy) const;
+    void   add(double energy, double value) { m_bins[key(energy)] += value; }
+    void   clear() { m_bins.clear(); }
+
+    std::size_t                            size() const { return m_bins.size(); }
+    std::map<std::int64_t, double>&       bins() { return m_bins; }
+    const std::map<std::int64_t, double>& bins() const { return m_bins; }
+};
+
+struct wang_landau_parameters {
+    std::size_t nb_windows            = 4;
+    std::size_t walkers_per_window    = 1;
+    double      window_overlap        = 0.75;
+    double      flatness              = 0.8;
+    double      ln_f_initial          = 1.0;
+    double      ln_f_final            = 1.0e-6;
+    std::size_t sweeps_between_checks = 100;
+    double      energy_resolution     = 1.0e-6;
+    std::string checkpoint_file       = "";
+    std::size_t checkpoint_interval   = 100;
+};
+
+/**
+ * @brief Replica-exchange Wang-Landau sampler.
+ *
+ * The energy range is split into overlapping windows, each explored by independent walkers (running in parallel with
+ * OpenMP) which only accept moves that keep them inside their window. Walkers of neighboring windows periodically
+ * exchange configurations. Once every window has converged, the partial estimates are stitched together into a single
+ * ln g(E), from which the thermodynamics at any temperature can be derived.
+ *
+ * The energy used here is the Hamiltonian (sum over bonds), i.e. half of ising_base::compute_total_energy(), which is
+ * consistent with ising_base::compute_flip_delta_energy().
+ */
+class wang_landau {
+ private:
+    struct energy_window {
+        double lower;
+        double upper;
+        double ln_f;
+    };
+
+    struct walker {
+        std::unique_ptr<ising_base> lattice;
+        std::mt19937                random_engine;
+        std::size_t                 window;
+        double                      energy;
+        double                      magnetization;
+        energy_histogram            ln_g;
+        energy_histogram            histogram;
+        energy_histogram            sum_abs_magnetization;
+        energy_histogram            sum_square_magnetization;
+        energy_histogram            nb_samples;
+    };
+
+    std::unique_ptr<ising_base> m_prototype;
+    wang_landau_parameters      m_parameters;
+    std::vector<energy_window>  m_windows;
+    std::vector<walker>         m_walkers;
+    std::size_t                 m_number_rounds = 0;
+    std::mt19937                m_random_engine;
+
+    energy_histogram m_ln_g;
+    energy_histogram m_mean_abs_magnetization;
+    energy_histogram m_mean_square_magnetization;
+
+    double compute_energy(const ising_base& lattice) const { return 0.5 * lattice.compute_total_energy(); }
+    void   estimate_energy_range(double& energy_min, double& energy_max);
+    void   drive_into_window(walker& current_walker);
+    void   walker_sweeps(walker& current_walker, std::size_t nb_sweeps);
+    void   replica_exchange();
+    void   update_modification_factors();
+    void   stitch_windows();
+
+    energy_histogram average_ln_g(std::size_t index_window) const;
+
+ public:
+    wang_landau(const ising_base& prototype, const wang_landau_parameters& parameters = {});
+
+    void initialize();
+    void initialize(double energy_min, double energy_max);
+    void run();
+    bool is_converged() const;
+
+    void set_seed(unsigned int seed) { m_random_engine.seed(seed); }
+
+    std::size_t get_number_rounds() const { return m_number_rounds; }
+
+    const energy_histogram& get_ln_density_of_states() const { return m_ln_g; }
+    ising_result            compute_thermodynamics(double temperature) const;
+
+    void export_density_of_states(const std::string& filename) const;
+    void save_checkpoint(const std::string& filename) const;
+    void load_checkpoint(const std::string& filename);
+};
@@ -0,0 +1,359 @@
+/**
+ * @file physics_checks.hpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Reference results, statistical checks and throughput records shared by the test executables.
+ * @version 0.1
+ * @date 2022-09-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numbers>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ising_base.hpp"
+
+namespace physics_checks {
+
+/**
+ * @brief Count the failed checks of a test executable and print one line per check.
+ *
+ */
+class test_report {
+ private:
+    std::size_t m_nb_checks   = 0;
+    std::size_t m_nb_failures = 0;
+
+ public:
+    void check(const std::string& name, bool success, const std::string& details = "") {
+        m_nb_checks++;
+        if (!success) {
+            m_nb_failures++;
+        }
+        std::cout << (success ? "[ OK ] " : "[FAIL] ") << name << (details.empty() ? "" : " : " + details) << std::endl;
+    }
+
+    /**
+     * @brief Check that |value - expected| <= tolerance.
+     */
+    void check_close(const std::string& name, double value, double expected, double tolerance) {
+        std::ostringstream details;
+        details << std::setprecision(6) << value << " vs " << expected << " (|diff| = " << std::abs(value - expected)
+                << ", tolerance = " << tolerance << ")";
+        check(name, std::abs(value - expected) <= tolerance, details.str());
+    }
+
+    int exit_code() const {
+        std::cout << m_nb_checks - m_nb_failures << " / " << m_nb_checks << " checks passed." << std::endl;
+        return m_nb_failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+};
+
+/**
+ * @brief Mean and standard error of a correlated time series, estimated with batch means.
+ *
+ * The series is cut in nb_batches consecutive blocks, the error is the standard deviation of the block averages
+ * divided by sqrt(nb_batches). Blocks must be long compared to the autocorrelation time.
+ */
+class batch_mean {
+ private:
+    std::vector<double> m_values;
+
+ public:
+    void add(double value) { m_values.push_back(value); }
+
+    double mean() const {
+        double sum = 0.0;
+        for (double value : m_values) {
+            sum += value;
+        }
+        return sum / static_cast<double>(m_values.size());
+    }
+
+    double standard_error(std::size_t nb_batches = 32) const {
+        const std::size_t batch_size = m_values.size() / nb_batches;
+        std::vector<double> batches(nb_batches, 0.0);
+        for (std::size_t index_batch = 0; index_batch < nb_batches; index_batch++) {
+            for (std::size_t index = 0; index < batch_size; index++) {
+                batches[index_batch] += m_values[index_batch * batch_size + index];
+            }
+            batches[index_batch] /= static_cast<double>(batch_size);
+        }
+        double mean_batches = 0.0;
+        for (double batch : batches) {
+            mean_batches += batch;
+        }
+        mean_batches /= static_cast<double>(nb_batches);
+        double variance = 0.0;
+        for (double batch : batches) {
+            variance += (batch - mean_batches) * (batch - mean_batches);
+        }
+        variance /= static_cast<double>(nb_batches - 1);
+        return std::sqrt(variance / static_cast<double>(nb_batches));
+    }
+};
+
+/**
+ * @brief Canonical averages per spin: energy (Hamiltonian, sum over bonds), |m|, m^2, specific heat and
+ * susceptibility (computed with |M| as in wang_landau::compute_thermodynamics).
+ */
+struct thermodynamics {
+    double energy;
+    double abs_magnetization;
+    double square_magnetization;
+    double specific_heat;
+    double susceptibility;
+};
+
+/**
+ * @brief Exact density of states g(E, |M|) of a small lattice, obtained by enumerating its 2^N configurations.
+ *
+ * The Hamiltonian is given independently of the lattice classes, as a list of bonds (i, j, J) contributing -J s_i s_j.
+ */
+class exact_enumeration {
+ public:
+    struct bond {
+        std::size_t first;
+        std::size_t second;
+        double      coupling;
+    };
+
+ private:
+    std::size_t                                       m_nb_spins;
+    double                                            m_resolution;
+    std::map<std::pair<std::int64_t, int>, double>    m_density_of_states;
+
+ public:
+    exact_enumeration(std::size_t nb_spins, const std::vector<bond>& bonds, double resolution = 1.0e-6)
+        : m_nb_spins(nb_spins), m_resolution(resolution) {
+        const std::uint64_t nb_configurations = std::uint64_t{1} << nb_spins;
+        for (std::uint64_t configuration = 0; configuration < nb_configurations; configuration++) {
+            double energy = 0.0;
+            for (const bond& current_bond : bonds) {
+                const bool aligned = ((configuration >> current_bond.first) & 1U) == ((configuration >> current_bond.second) & 1U);
+                energy -= aligned ? current_bond.coupling : -current_bond.coupling;
+            }
+            const int magnetization = 2 * std::popcount(configuration) - static_cast<int>(nb_spins);
+            m_density_of_states[{std::llround(energy / m_resolution), std::abs(magnetization)}] += 1.0;
+        }
+    }
+
+    double energy(std::int64_t key) const { return static_cast<double>(key) * m_resolution; }
+
+    /**
+     * @brief ln g(E), summed over the magnetization.
+     */
+    std::map<std::int64_t, double> ln_density_of_states() const {
+        std::map<std::int64_t, double> density;
+        for (const auto& [key, count] : m_density_of_states) {
+            density[key.first] += count;
+        }
+        for (auto& [key, value] : density) {
+            value = std::log(value);
+        }
+        return density;
+    }
+
+    thermodynamics compute(double temperature) const {
+        double min_energy = 0.0;
+        for (const auto& [key, count] : m_density_of_states) {
+            min_energy = std::min(min_energy, energy(key.first));
+        }
+        double partition_function = 0.0, sum_energy = 0.0, sum_square_energy = 0.0, sum_abs_magnet = 0.0, sum_square_magnet = 0.0;
+        for (const auto& [key, count] : m_density_of_states) {
+            const double current_energy = energy(key.first);
+            const double magnetization  = static_cast<double>(key.second);
+            const double weight         = count * std::exp(-(current_energy - min_energy) / temperature);
+            partition_function += weight;
+            sum_energy += weight * current_energy;
+            sum_square_energy += weight * current_energy * current_energy;
+            sum_abs_magnet += weight * magnetization;
+            sum_square_magnet += weight * magnetization * magnetization;
+        }
+        const double nb_spins        = static_cast<double>(m_nb_spins);
+        const double mean_energy     = sum_energy / partition_function;
+        const double mean_abs_magnet = sum_abs_magnet / partition_function;
+        const double mean_square_mag = sum_square_magnet / partition_function;
+        return {mean_energy / nb_spins,
+                mean_abs_magnet / nb_spins,
+                mean_square_mag / (nb_spins * nb_spins),
+                (sum_square_energy / partition_function - mean_energy * mean_energy) / (nb_spins * temperature * temperature),
+                (mean_square_mag - mean_abs_magnet * mean_abs_magnet) / (nb_spins * temperature)};
+    }
+};
+
+/**
+ * @brief Onsager's exact results for the isotropic square lattice (J = 1, k_B = 1) in the thermodynamic limit.
+ *
+ */
+namespace onsager {
+
+inline const double critical_temperature = 2.0 / std::log(1.0 + std::numbers::sqrt2);
+
+/**
+ * @brief Internal energy per spin: u = -coth(2b) [1 + 2/pi (2 tanh^2(2b) - 1) K(k)], k = 2 sinh(2b) / cosh^2(2b).
+ */
+inline double energy_per_spin(double temperature) {
+    const double beta    = 1.0 / temperature;
+    const double modulus = 2.0 * std::sinh(2.0 * beta) / (std::cosh(2.0 * beta) * std::cosh(2.0 * beta));
+    const double tanh_2b = std::tanh(2.0 * beta);
+    return -1.0 / tanh_2b * (1.0 + 2.0 / std::numbers::pi * (2.0 * tanh_2b * tanh_2b - 1.0) * std::comp_ellint_1(modulus));
+}
+
+/**
+ * @brief Spontaneous magnetization per spin: m = (1 - sinh(2b)^-4)^(1/8) below T_c, 0 above.
+ */
+inline double magnetization_per_spin(double temperature) {
+    if (temperature >= critical_temperature) {
+        return 0.0;
+    }
+    const double sinh_2b = std::sinh(2.0 / temperature);
+    return std::pow(1.0 - std::pow(sinh_2b, -4.0), 0.125);
+}
+
+}  // namespace onsager
+
+/**
+ * @brief Time-series of a Metropolis run on a lattice, with the time spent in the update kernel only.
+ *
+ */
+struct sampled_run {
+    batch_mean  energy;
+    batch_mean  abs_magnetization;
+    batch_mean  square_magnetization;
+    batch_mean  fourth_magnetization;
+    double      kernel_seconds = 0.0;
+    std::size_t nb_attempts    = 0;
+
+    double attempts_per_second() const { return static_cast<double>(nb_attempts) / kernel_seconds; }
+};
+
+/**
+ * @brief Thermalize then sample a lattice, calling sweep(lattice) for each Metropolis sweep (N attempts).
+ *
+ * Observables are per spin, the energy being the Hamiltonian (half of ising_base::compute_total_energy()).
+ */
+template <typename Lattice>
+sampled_run sample(Lattice& lattice, const std::function<void(Lattice&)>& sweep, std::size_t nb_thermalization, std::size_t nb_samples) {
+    for (std::size_t index = 0; index < nb_thermalization; index++) {
+        sweep(lattice);
+    }
+    sampled_run  run;
+    const double nb_spins = static_cast<double>(lattice.get_number_spins());
+    for (std::size_t index = 0; index < nb_samples; index++) {
+        const auto start = std::chrono::steady_clock::now();
+        sweep(lattice);
+        run.kernel_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.nb_attempts += lattice.get_number_spins();
+
+        double magnetization = 0.0;
+        for (double spin : lattice.get_spins()) {
+            magnetization += spin;
+        }
+        magnetization /= nb_spins;
+        run.energy.add(0.5 * lattice.compute_total_energy() / nb_spins);
+        run.abs_magnetization.add(std::abs(magnetization));
+        run.square_magnetization.add(magnetization * magnetization);
+        run.fourth_magnetization.add(magnetization * magnetization * magnetization * magnetization);
+    }
+    return run;
+}
+
+/**
+ * @brief Append throughput measurements to a CSV file and compare them to a baseline.
+ *
+ * Records go to $ISING_THROUGHPUT_FILE (default: ising_throughput.csv in the working directory), one line per
+ * (test, engine, shape) with the number of flip attempts per second spent in the update kernel.
+ *
+ * When $ISING_THROUGHPUT_BASELINE names a previous record file, each measurement is compared to the last baseline
+ * entry with the same key: a throughput lower than (1 - tolerance) times the baseline fails the check, a higher one
+ * than (1 + tolerance) times the baseline is reported as a speed-up. The tolerance is $ISING_THROUGHPUT_TOLERANCE
+ * (default 0.25). Without a baseline, throughput is only recorded.
+ */
+class throughput_log {
+ private:
+    std::string                   m_test_name;
+    std::ofstream                 m_file;
+    std::map<std::string, double> m_baseline;
+    double                        m_tolerance = 0.25;
+
+    static std::string getenv_or(const char* name, const std::string& default_value) {
+        const char* value = std::getenv(name);
+        return value != nullptr ? std::string(value) : default_value;
+    }
+
+ public:
+    explicit throughput_log(const std::string& test_name) : m_test_name(test_name) {
+        const std::string filename   = getenv_or("ISING_THROUGHPUT_FILE", "ising_throughput.csv");
+        const bool        new_file   = !std::filesystem::exists(filename);
+        m_file.open(filename, std::ios::app);
+        if (new_file) {
+            m_file << "timestamp,test,engine,shape,nb_attempts,seconds,attempts_per_second\n";
+        }
+        m_tolerance = std::stod(getenv_or("ISING_THROUGHPUT_TOLERANCE", "0.25"));
+
+        const std::string baseline_file = getenv_or("ISING_THROUGHPUT_BASELINE", "");
+        if (!baseline_file.empty()) {
+            std::ifstream baseline(baseline_file);
+            std::string   line;
+            std::getline(baseline, line);
+            while (std::getline(baseline, line)) {
+                std::istringstream       stream(line);
+                std::vector<std::string> fields;
+                std::string              field;
+                while (std::getline(stream, field, ',')) {
+                    fields.push_back(field);
+                }
+                if (fields.size() == 7) {
+                    m_baseline[fields[1] + "," + fields[2] + "," + fields[3]] = std::stod(fields[6]);
+                }
+            }
+        }
+    }
+
+    static std::string shape_name(const std::array<std::size_t, 3>& shape) {
+        return std::to_string(shape[0]) + "x" + std::to_string(shape[1]) + "x" + std::to_string(shape[2]);
+    }
+
+    void record(test_report& report, const std::string& engine, const std::array<std::size_t, 3>& shape, const sampled_run& run) {
+        const std::string key        = m_test_name + "," + engine + "," + shape_name(shape);
+        const double      throughput = run.attempts_per_second();
+        m_file << std::time(nullptr) << "," << key << "," << run.nb_attempts << "," << run.kernel_seconds << "," << throughput << "\n";
+        m_file.flush();
+
+        auto baseline = m_baseline.find(key);
+        if (baseline == m_baseline.end()) {
+            std::cout << "[INFO] throughput " << key << " : " << throughput << " attempts/s" << std::endl;
+            return;
+        }
+        const double      ratio = throughput / baseline->second;
+        std::ostringstream details;
+        details << throughput << " attempts/s, " << std::setprecision(3) << ratio << "x baseline";
+        if (ratio > 1.0 + m_tolerance) {
+            details << " (speed-up)";
+        }
+        report.check("throughput " + key, ratio >= 1.0 - m_tolerance, details.str());
+    }
+};
+
+}  // namespace physics_checks
@@ -0,0 +1,105 @@
+/**
+ * @file test_autotuner.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Checks of the kernel autotuner: equivalence of the candidates, selection and tuning cache.
+ * @version 0.1
+ * @date 2022-10-05
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "autotuner.hpp"
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+int main() {
+    test_report       report;
+    const std::string cache_file = "test_autotuner_cache.csv";
+    std::filesystem::remove(cache_file);
+
+    autotune_options options;
+    options.max_threads = 2;
+    options.cache_file  = cache_file;
+
+    // The threaded metropolis_step() is the parallel sweep.
+    {
+        ising_2d dispatched(32, 16, 2.0);
+        ising_2d direct(32, 16, 2.0);
+        dispatched.set_seed(35);
+        direct.set_seed(35);
+        dispatched.set_number_threads(2);
+        for (int step = 0; step < 10; step++) {
+            dispatched.metropolis_step();
+            direct.metropolis_step_parallel(2);
+        }
+        report.check("set_number_threads dispatches to the parallel sweep", dispatched.get_spins() == direct.get_spins());
+
+        // A new thread count moves the spins to a buffer touched with the new decomposition, keeping them.
+        const std::vector<double> spins(dispatched.get_spins().begin(), dispatched.get_spins().end());
+        const double* const       previous_data = dispatched.get_spin_data();
+        dispatched.set_number_threads(3);
+        report.check("set_number_threads relocates the spins",
+                     dispatched.get_spin_data() != previous_data && std::equal(spins.begin(), spins.end(), dispatched.get_spins().begin()));
+    }
+
+    for (int dimension : {2, 3}) {
+        std::unique_ptr<ising_base> lattice;
+        if (dimension == 2) {
+            lattice = std::make_unique<ising_2d>(48, 48, 2.0);
+        } else {
+            lattice = std::make_unique<ising_3d>(12, 12, 12, 4.0);
+        }
+        lattice->set_seed(35);
+        const std::string name = std::to_string(dimension) + "d";
+
+        kernel_autotuner    tuner(options);
+        const tuning_result result = tuner.tune(*lattice);
+        const auto&         measurements = tuner.get_measurements();
+        report.check(name + " benchmarks every candidate", measurements.size() == 4, std::to_string(measurements.size()) + " candidates");
+        report.check(name + " correct kernels are equivalent",
+                     std::all_of(measurements.begin(), measurements.end(), [](const kernel_measurement& m) { return m.equivalent; }));
+        const auto best = std::max_element(measurements.begin(), measurements.end(), [](const auto& a, const auto& b) {
+            return a.attempts_per_second < b.attempts_per_second;
+        });
+        report.check(name + " selects the fastest kernel",
+                     !result.from_cache && to_string(result.configuration) == to_string(best->configuration),
+                     to_string(result.configuration));
+        report.check(name + " applies the kernel",
+                     lattice->get_sweep_order() == result.configuration.order &&
+                         lattice->get_number_threads() == result.configuration.nb_threads);
+
+        lattice->set_sweep_order(sweep_order::random);
+        lattice->set_number_threads(1);
+        kernel_autotuner    cached_tuner(options);
+        const tuning_result cached = cached_tuner.tune(*lattice);
+        report.check(name + " second run comes from the cache",
+                     cached.from_cache && cached_tuner.get_measurements().empty() &&
+                         to_string(cached.configuration) == to_string(result.configuration) &&
+                         lattice->get_number_threads() == result.configuration.nb_threads);
+    }
+
+    // File-backed lattices are not cloned for the benchmark.
+    {
+        ising_3d         file_backed(8, 8, 8, 4.0, ".");
+        kernel_autotuner tuner(options);
+        bool             rejected = false;
+        try {
+            tuner.tune(file_backed);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        report.check("file-backed lattice is rejected", rejected && tuner.get_measurements().empty());
+    }
+    std::filesystem::remove(cache_file);
+    return report.exit_code();
+}
@@ -0,0 +1,289 @@
+/**
+ * @file test_correlation.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check the FFT plans against a naive DFT, and G(r), S(k) and xi against direct sums and known configurations.
+ * @version 0.1
+ * @date 2022-10-13
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "correlation.hpp"
+#include "fft.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+using complex = std::complex<double>;
+using shape_3 = std::array<std::size_t, 3>;
+
+std::size_t linear_index(const shape_3& shape, std::size_t x, std::size_t y, std::size_t z) { return x + y * shape[0] + z * shape[0] * shape[1]; }
+
+/**
+ * @brief Naive unnormalized DFT of an array of the given shape (x fastest), forward: exp(-2i pi k.r / L).
+ */
+std::vector<complex> naive_dft(const shape_3& shape, const std::vector<complex>& data, bool inverse) {
+    const double         sign = inverse ? 1.0 : -1.0;
+    std::vector<complex> result(data.size(), 0.0);
+    for (std::size_t kz = 0; kz < shape[2]; kz++) {
+        for (std::size_t ky = 0; ky < shape[1]; ky++) {
+            for (std::size_t kx = 0; kx < shape[0]; kx++) {
+                complex sum = 0.0;
+                for (std::size_t z = 0; z < shape[2]; z++) {
+                    for (std::size_t y = 0; y < shape[1]; y++) {
+                        for (std::size_t x = 0; x < shape[0]; x++) {
+                            const double phase = static_cast<double>(kx * x) / static_cast<double>(shape[0]) +
+                                                 static_cast<double>(ky * y) / static_cast<double>(shape[1]) +
+                                                 static_cast<double>(kz * z) / static_cast<double>(shape[2]);
+                            sum += data[linear_index(shape, x, y, z)] * std::polar(1.0, sign * 2.0 * M_PI * phase);
+                        }
+                    }
+                }
+                result[linear_index(shape, kx, ky, kz)] = sum;
+            }
+        }
+    }
+    return result;
+}
+
+double max_difference(const std::vector<complex>& a, const complex* b) {
+    double difference = 0.0;
+    for (std::size_t index = 0; index < a.size(); index++) {
+        difference = std::max(difference, std::abs(a[index] - b[index]));
+    }
+    return difference;
+}
+
+std::vector<complex> random_complex_data(std::size_t size, std::mt19937& random_engine) {
+    std::normal_distribution<double> distribution(0.0, 1.0);
+    std::vector<complex>             data(size);
+    for (complex& value : data) {
+        value = {distribution(random_engine), distribution(random_engine)};
+    }
+    return data;
+}
+
+/**
+ * @brief Direct O(N^2) evaluation of the radially averaged G(r) and S(k), with the binning documented in
+ * correlation_analyzer: minimum image, bins of one lattice spacing and of 2 pi / L_min, up to L_min / 2 and pi.
+ */
+correlation_measurement reference_correlations(const shape_3& shape, const std::vector<double>& spins) {
+    std::size_t min_size = 0;
+    for (std::size_t size : shape) {
+        if (size > 1) {
+            min_size = min_size == 0 ? size : std::min(min_size, size);
+        }
+    }
+    const std::size_t       nb_bins = min_size / 2 + 1;
+    const double            dk      = 2.0 * M_PI / static_cast<double>(min_size);
+    const double            n       = static_cast<double>(spins.size());
+    correlation_measurement reference;
+    reference.correlation.assign(nb_bins, 0.0);
+    reference.structure_factor.assign(nb_bins, 0.0);
+    std::vector<double> distance_counts(nb_bins, 0.0);
+    std::vector<double> wave_number_counts(nb_bins, 0.0);
+
+    std::vector<complex> spins_complex(spins.begin(), spins.end());
+    const auto           transform = naive_dft(shape, spins_complex, false);
+    for (std::size_t z = 0; z < shape[2]; z++) {
+        for (std::size_t y = 0; y < shape[1]; y++) {
+            for (std::size_t x = 0; x < shape[0]; x++) {
+                const shape_3 position = {x, y, z};
+                double        r2       = 0.0;
+                double        k2       = 0.0;
+                for (std::size_t axis = 0; axis < 3; axis++) {
+                    const double image = static_cast<double>(std::min(position[axis], shape[axis] - position[axis]));
+                    r2 += image * image;
+                    k2 += std::pow(2.0 * M_PI * image / static_cast<double>(shape[axis]), 2);
+                }
+                // G at the displacement (x, y, z): average of s_j s_{j + r} over the sites j.
+                double product_sum = 0.0;
+                for (std::size_t jz = 0; jz < shape[2]; jz++) {
+                    for (std::size_t jy = 0; jy < shape[1]; jy++) {
+                        for (std::size_t jx = 0; jx < shape[0]; jx++) {
+                            product_sum += spins[linear_index(shape, jx, jy, jz)] *
+                                           spins[linear_index(shape, (jx + x) % shape[0], (jy + y) % shape[1], (jz + z) % shape[2])];
+                        }
+                    }
+                }
+                const std::size_t distance_bin = static_cast<std::size_t>(std::lround(std::sqrt(r2)));
+                const std::size_t k_bin        = static_cast<std::size_t>(std::lround(std::sqrt(k2) / dk));
+                if (distance_bin < nb_bins) {
+                    reference.correlation[distance_bin] += product_sum / n;
+                    distance_counts[distance_bin] += 1.0;
+                }
+                if (k_bin < nb_bins) {
+                    reference.structure_factor[k_bin] += std::norm(transform[linear_index(shape, x, y, z)]) / n;
+                    wave_number_counts[k_bin] += 1.0;
+                }
+            }
+        }
+    }
+    for (std::size_t bin = 0; bin < nb_bins; bin++) {
+        reference.correlation[bin] /= std::max(distance_counts[bin], 1.0);
+        reference.structure_factor[bin] /= std::max(wave_number_counts[bin], 1.0);
+    }
+    return reference;
+}
+
+double max_difference(const std::vector<double>& a, const std::vector<double>& b) {
+    double difference = a.size() == b.size() ? 0.0 : std::numeric_limits<double>::infinity();
+    for (std::size_t index = 0; index < std::min(a.size(), b.size()); index++) {
+        difference = std::max(difference, std::abs(a[index] - b[index]));
+    }
+    return difference;
+}
+
+void check_against_reference(test_report& report, const std::string& name, const shape_3& shape, const std::vector<double>& spins) {
+    correlation_analyzer           analyzer(shape);
+    const correlation_measurement& measured  = analyzer.measure(spins.data());
+    const correlation_measurement  reference = reference_correlations(shape, spins);
+    report.check_close(name + " G(r) against direct sums", max_difference(measured.correlation, reference.correlation), 0.0, 1.0e-10);
+    report.check_close(name + " S(k) against direct sums", max_difference(measured.structure_factor, reference.structure_factor), 0.0, 1.0e-9);
+}
+
+}  // namespace
+
+int main() {
+    test_report  report;
+    std::mt19937 random_engine(29);
+
+    // 1D plans: radix-2 for powers of two, Bluestein for the other lengths (primes, even and odd composites).
+    for (std::size_t size : {1, 2, 8, 64, 256, 3, 5, 6, 12, 17, 100, 243}) {
+        const auto  data = random_complex_data(size, random_engine);
+        fft_plan_1d plan(size);
+        for (bool inverse : {false, true}) {
+            std::vector<complex> transformed = data;
+            plan.execute(transformed.data(), inverse);
+            const double error = max_difference(naive_dft({size, 1, 1}, data, inverse), transformed.data());
+            report.check_close("1d " + std::string(inverse ? "inverse" : "forward") + " n=" + std::to_string(size), error, 0.0,
+                               1.0e-10 * static_cast<double>(size));
+        }
+    }
+
+    // Multi-dimensional plans, with axes of size 1 and mixed lengths, and the forward-inverse round trip.
+    for (const shape_3& shape : {shape_3{8, 4, 1}, shape_3{6, 5, 4}, shape_3{1, 7, 8}, shape_3{16, 1, 3}}) {
+        const std::string name = "nd " + std::to_string(shape[0]) + "x" + std::to_string(shape[1]) + "x" + std::to_string(shape[2]);
+        const auto        data = random_complex_data(shape[0] * shape[1] * shape[2], random_engine);
+        fft_plan_nd       plan(shape);
+        complex_vector    transformed(data.begin(), data.end());
+        plan.forward(transformed);
+        report.check_close(name + " forward", max_difference(naive_dft(shape, data, false), transformed.data()), 0.0, 1.0e-9);
+        plan.inverse(transformed);
+        for (complex& value : transformed) {
+            value /= static_cast<double>(data.size());
+        }
+        report.check_close(name + " round trip", max_difference(data, transformed.data()), 0.0, 1.0e-12);
+    }
+
+    // Random configurations against the direct sums, in 2D and 3D.
+    {
+        std::bernoulli_distribution up(0.6);
+        for (const shape_3& shape : {shape_3{12, 10, 1}, shape_3{6, 5, 4}}) {
+            std::vector<double> spins(shape[0] * shape[1] * shape[2]);
+            std::generate(spins.begin(), spins.end(), [&]() { return up(random_engine) ? 1.0 : -1.0; });
+            check_against_reference(report, "random " + std::to_string(shape[2] > 1 ? 3 : 2) + "d", shape, spins);
+        }
+    }
+
+    const shape_3     shape    = {16, 16, 1};
+    const std::size_t nb_spins = 16 * 16;
+
+    // All up: G(r) = 1, no connected correlation, all the weight in S(0) = N, infinite correlation length.
+    {
+        const std::vector<double>      spins(nb_spins, 1.0);
+        correlation_analyzer           analyzer(shape);
+        const correlation_measurement& measured = analyzer.measure(spins.data());
+        report.check_close("all up G(r) = 1", max_difference(measured.correlation, std::vector<double>(measured.correlation.size(), 1.0)), 0.0, 1.0e-12);
+        report.check_close("all up connected G(r) = 0",
+                           max_difference(measured.connected_correlation, std::vector<double>(measured.correlation.size(), 0.0)), 0.0, 1.0e-12);
+        report.check_close("all up S(0) = N", measured.structure_factor[0], static_cast<double>(nb_spins), 1.0e-9);
+        report.check_close("all up S(k > 0) = 0",
+                           *std::max_element(measured.structure_factor.begin() + 1, measured.structure_factor.end()), 0.0, 1.0e-9);
+        report.check_close("all up magnetization", measured.magnetization, 1.0, 1.0e-12);
+        report.check("all up infinite correlation length", std::isinf(measured.correlation_length));
+    }
+
+    // Checkerboard: S(k) is a single peak of height N at (pi, pi), G alternates with the parity of the displacement.
+    {
+        std::vector<double> spins(nb_spins);
+        for (std::size_t y = 0; y < 16; y++) {
+            for (std::size_t x = 0; x < 16; x++) {
+                spins[linear_index(shape, x, y, 0)] = (x + y) % 2 == 0 ? 1.0 : -1.0;
+            }
+        }
+        fft_plan_nd    plan(shape);
+        complex_vector transformed(spins.begin(), spins.end());
+        plan.forward(transformed);
+        double      off_peak = 0.0;
+        std::size_t peak     = 0;
+        for (std::size_t index = 0; index < nb_spins; index++) {
+            if (std::norm(transformed[index]) > std::norm(transformed[peak])) {
+                peak = index;
+            }
+        }
+        for (std::size_t index = 0; index < nb_spins; index++) {
+            off_peak = std::max(off_peak, index == peak ? 0.0 : std::norm(transformed[index]) / static_cast<double>(nb_spins));
+        }
+        report.check("checkerboard S(k) peaks at (pi, pi)", peak == linear_index(shape, 8, 8, 0), "peak at index " + std::to_string(peak));
+        report.check_close("checkerboard S(pi, pi) = N", std::norm(transformed[peak]) / static_cast<double>(nb_spins), static_cast<double>(nb_spins), 1.0e-9);
+        report.check_close("checkerboard S elsewhere = 0", off_peak, 0.0, 1.0e-9);
+
+        correlation_analyzer           analyzer(shape);
+        const correlation_measurement& measured = analyzer.measure(spins.data());
+        report.check_close("checkerboard magnetization", measured.magnetization, 0.0, 1.0e-9);
+        report.check_close("checkerboard G(0) = 1", measured.correlation[0], 1.0, 1.0e-12);
+        report.check_close("checkerboard radial S(k <= pi) = 0", *std::max_element(measured.structure_factor.begin(), measured.structure_factor.end()),
+                           0.0, 1.0e-9);
+        check_against_reference(report, "checkerboard", shape, spins);
+    }
+
+    // Single stripe: one row down in an up lattice. The weight is on the k_x = 0 line, S(0, k_y != 0) = 4.
+    {
+        std::vector<double> spins(nb_spins, 1.0);
+        std::fill(spins.begin(), spins.begin() + 16, -1.0);
+        fft_plan_nd    plan(shape);
+        complex_vector transformed(spins.begin(), spins.end());
+        plan.forward(transformed);
+        double line_error     = 0.0;
+        double off_line_power = 0.0;
+        for (std::size_t ky = 1; ky < 16; ky++) {
+            line_error = std::max(line_error, std::abs(std::norm(transformed[linear_index(shape, 0, ky, 0)]) / nb_spins - 4.0));
+            for (std::size_t kx = 1; kx < 16; kx++) {
+                off_line_power = std::max(off_line_power, std::norm(transformed[linear_index(shape, kx, ky, 0)]) / nb_spins);
+            }
+        }
+        report.check_close("stripe S(0, k_y) = 4", line_error, 0.0, 1.0e-9);
+        report.check_close("stripe S(k_x != 0) = 0", off_line_power, 0.0, 1.0e-9);
+
+        correlation_analyzer           analyzer(shape);
+        const correlation_measurement& measured = analyzer.measure(spins.data());
+        report.check_close("stripe S(0)", measured.structure_factor[0], 14.0 * 14.0 * 16.0 * 16.0 / nb_spins, 1.0e-9);
+        report.check_close("stripe magnetization", measured.magnetization, 14.0 / 16.0, 1.0e-12);
+        check_against_reference(report, "stripe", shape, spins);
+    }
+
+    // Correlation length: infinite for the ordered lattice, short for uncorrelated spins.
+    {
+        std::vector<double>         spins(64 * 64);
+        std::bernoulli_distribution up(0.5);
+        std::generate(spins.begin(), spins.end(), [&]() { return up(random_engine) ? 1.0 : -1.0; });
+        correlation_analyzer           analyzer({64, 64, 1});
+        const correlation_measurement& measured = analyzer.measure(spins.data());
+        report.check("uncorrelated spins have xi < 1", measured.correlation_length >= 0.0 && measured.correlation_length < 1.0,
+                     std::to_string(measured.correlation_length));
+    }
+    return report.exit_code();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_domains.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check the parallel domain labeling against a breadth-first search, and its recording along a simulation.
+ * @version 0.1
+ * @date 2022-10-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <array>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "domains.hpp"
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+/**
+ * @brief Serial reference: breadth-first search of the domains through the bonds, in both directions.
+ */
+domain_measurement reference_domains(const ising_base& lattice) {
+    const auto                        shape    = lattice.get_shape();
+    const auto                        bonds    = lattice.get_bond_displacements();
+    const std::size_t                 nb_spins = lattice.get_number_spins();
+    std::vector<bool>                 visited(nb_spins, false);
+    std::vector<std::size_t>          sizes;
+    domain_measurement                measurement;
+    auto neighbor = [&](std::size_t index, const std::array<std::size_t, 3>& bond, bool forward) {
+        std::array<std::size_t, 3> position = {index % shape[0], (index / shape[0]) % shape[1], index / (shape[0] * shape[1])};
+        for (std::size_t axis = 0; axis < 3; axis++) {
+            position[axis] = (position[axis] + (forward ? bond[axis] : shape[axis] - bond[axis] % shape[axis])) % shape[axis];
+        }
+        return position[0] + position[1] * shape[0] + position[2] * shape[0] * shape[1];
+    };
+    for (std::size_t start = 0; start < nb_spins; start++) {
+        for (const auto& bond : bonds) {
+            measurement.interface_length += lattice.get_spin_at(start) != lattice.get_spin_at(neighbor(start, bond, true));
+        }
+        if (visited[start]) {
+            continue;
+        }
+        std::size_t             size = 0;
+        std::queue<std::size_t> queue;
+        queue.push(start);
+        visited[start] = true;
+        while (!queue.empty()) {
+            const std::size_t index = queue.front();
+            queue.pop();
+            size++;
+            for (const auto& bond : bonds) {
+                for (bool forward : {true, false}) {
+                    const std::size_t other = neighbor(index, bond, forward);
+                    if (!visited[other] && lattice.get_spin_at(other) == lattice.get_spin_at(index)) {
+                        visited[other] = true;
+                        queue.push(other);
+                    }
+                }
+            }
+        }
+        sizes.push_back(size);
+    }
+    measurement.nb_domains = sizes.size();
+    for (std::size_t size : sizes) {
+        std::size_t bin = 0;
+        while ((size >> (bin + 1)) != 0) {
+            bin++;
+        }
+        if (measurement.size_histogram.size() <= bin) {
+            measurement.size_histogram.resize(bin + 1, 0);
+        }
+        measurement.size_histogram[bin]++;
+        measurement.largest_domain_size = std::max(measurement.largest_domain_size, size);
+    }
+    return measurement;
+}
+
+void check_against_reference(test_report& report, const std::string& name, const ising_base& lattice, int nb_threads) {
+    domain_analyzer           analyzer(lattice.get_shape(), lattice.get_bond_displacements(), nb_threads);
+    const domain_measurement& measured  = analyzer.measure(lattice.get_spins().data());
+    domain_measurement        reference = reference_domains(lattice);
+    reference.size_histogram.resize(measured.size_histogram.size(), 0);
+    const std::string label = name + " (" + std::to_string(nb_threads) + " threads)";
+    report.check(label + " domain count", measured.nb_domains == reference.nb_domains,
+                 std::to_string(measured.nb_domains) + " vs " + std::to_string(reference.nb_domains));
+    report.check(label + " largest domain", measured.largest_domain_size == reference.largest_domain_size);
+    report.check(label + " size histogram", measured.size_histogram == reference.size_histogram);
+    report.check(label + " interface length", measured.interface_length == reference.interface_length);
+}
+
+}  // namespace
+
+int main() {
+    test_report report;
+
+    // Random configurations around the percolation threshold, with odd sizes, sizes of 2 (double bonds) and more
+    // threads than planes.
+    for (double probability : {0.5, 0.7}) {
+        const std::string suffix = " p=" + std::to_string(probability).substr(0, 3);
+        ising_2d          square(37, 23, 2.0);
+        square.set_seed(37);
+        square.initialize_random(probability);
+        ising_3d cubic(9, 7, 5, 4.0);
+        cubic.set_seed(37);
+        cubic.initialize_random(probability);
+        ising_3d thin(6, 5, 2, 4.0);
+        thin.set_seed(37);
+        thin.initialize_random(probability);
+        for (int nb_threads : {1, 2, 3, 8}) {
+            check_against_reference(report, "2d 37x23" + suffix, square, nb_threads);
+            check_against_reference(report, "3d 9x7x5" + suffix, cubic, nb_threads);
+            check_against_reference(report, "3d 6x5x2" + suffix, thin, nb_threads);
+        }
+    }
+
+    // Uniform and striped configurations, domains closed through the periodic boundaries.
+    {
+        ising_2d lattice(8, 8, 1.0);
+        domain_analyzer analyzer(lattice.get_shape(), lattice.get_bond_displacements());
+        const domain_measurement& uniform = analyzer.measure(lattice.get_spins().data());
+        report.check("uniform: one domain", uniform.nb_domains == 1 && uniform.largest_domain_fraction == 1.0 && uniform.interface_length == 0);
+        for (std::size_t y = 0; y < 8; y++) {
+            for (std::size_t x = 0; x < 8; x++) {
+                lattice.set_spin(x, y, (y / 2) % 2 == 0 ? 1.0 : -1.0);
+            }
+        }
+        const domain_measurement& stripes = analyzer.measure(lattice.get_spins().data());
+        report.check("stripes: four domains", stripes.nb_domains == 4 && stripes.size_histogram[4] == 4, std::to_string(stripes.nb_domains));
+        report.check("stripes: four walls", stripes.interface_length == 4 * 8);
+    }
+
+    // Isotropic couplings: the interface length gives the energy, compute_total_energy() = -2 (N_bonds - 2 N_interface).
+    {
+        ising_3d lattice(10, 8, 6, 4.0);
+        lattice.set_seed(37);
+        lattice.initialize_random(0.5);
+        domain_analyzer           analyzer(lattice.get_shape(), lattice.get_bond_displacements());
+        const domain_measurement& measurement = analyzer.measure(lattice.get_spins().data());
+        const double nb_bonds = static_cast<double>(lattice.get_number_spins() * lattice.get_bond_displacements().size());
+        report.check_close("interface length matches the energy", lattice.compute_total_energy(),
+                           -2.0 * (nb_bonds - 2.0 * static_cast<double>(measurement.interface_length)), 1.0e-9);
+    }
+
+    // Coarsening run: one line every stride sweeps.
+    {
+        ising_2d lattice(48, 48, 1.5);
+        lattice.set_seed(37);
+        lattice.initialize_random(0.5);
+        lattice.set_domain_measurement(5, "test_domains", 3);
+        for ([[maybe_unused]] const sweep_record& record : lattice.simulate(40)) {
+        }
+        std::ifstream            file("test_domains_domains.csv");
+        std::string              line;
+        std::vector<std::string> lines;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        report.check("one record every 5 sweeps", lines.size() == 1 + 8, std::to_string(lines.size()) + " lines");
+        report.check("record header", !lines.empty() && lines.front().rfind("iteration,nb_domains,largest_domain_fraction,interface_length,size_1", 0) == 0);
+        report.check("last record", lines.size() > 1 && lines.back().rfind("40,", 0) == 0);
+    }
+
+    // The union-find array stays in memory: no measurement on a lattice larger than the RAM.
+    {
+        ising_3d file_backed(8, 8, 8, 4.0, ".");
+        bool     refused = false;
+        try {
+            file_backed.set_domain_measurement(5, "test_domains_file_backed");
+        } catch (const std::logic_error&) {
+            refused = true;
+        }
+        report.check("file-backed lattice is refused", refused);
+    }
+    return report.exit_code();
+}
@@ -0,0 +1,203 @@
+/**
+ * @file test_exact_enumeration.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check every update engine and Wang-Landau against the exact enumeration of tiny lattices.
+ * @version 0.1
+ * @date 2022-09-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+#include "wang_landau.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+constexpr std::size_t nb_thermalization = 2000;
+constexpr std::size_t nb_samples        = 64000;
+constexpr double      nb_sigmas         = 4.0;
+
+/**
+ * @brief Bonds of the 2D lattice: (x, y) -- (x + 1, y) with J_x and (x, y) -- (x, y + 1) with J_y.
+ */
+std::vector<exact_enumeration::bond> bonds_2d(std::size_t size_x, std::size_t size_y, double coupling_x, double coupling_y) {
+    std::vector<exact_enumeration::bond> bonds;
+    for (std::size_t y = 0; y < size_y; y++) {
+        for (std::size_t x = 0; x < size_x; x++) {
+            const std::size_t site = x + y * size_x;
+            bonds.push_back({site, (x + 1) % size_x + y * size_x, coupling_x});
+            bonds.push_back({site, x + ((y + 1) % size_y) * size_x, coupling_y});
+        }
+    }
+    return bonds;
+}
+
+/**
+ * @brief Bonds of the 3D lattice: along x, y, z and along the in-plane diagonal (x + 1, y + 1), with J = 1.
+ */
+std::vector<exact_enumeration::bond> bonds_3d(std::size_t size_x, std::size_t size_y, std::size_t size_z) {
+    std::vector<exact_enumeration::bond> bonds;
+    auto index = [&](std::size_t x, std::size_t y, std::size_t z) { return x + y * size_x + z * size_x * size_y; };
+    for (std::size_t z = 0; z < size_z; z++) {
+        for (std::size_t y = 0; y < size_y; y++) {
+            for (std::size_t x = 0; x < size_x; x++) {
+                const std::size_t site = index(x, y, z);
+                bonds.push_back({site, index((x + 1) % size_x, y, z), 1.0});
+                bonds.push_back({site, index(x, (y + 1) % size_y, z), 1.0});
+                bonds.push_back({site, index(x, y, (z + 1) % size_z), 1.0});
+                bonds.push_back({site, index((x + 1) % size_x, (y + 1) % size_y, z), 1.0});
+            }
+        }
+    }
+    return bonds;
+}
+
+/**
+ * @brief The lattice energy and flip energies must match the bond list on random configurations.
+ */
+void check_hamiltonian(test_report&                                report,
+                       const std::string&                          name,
+                       ising_base&                                 lattice,
+                       const std::vector<exact_enumeration::bond>& bonds) {
+    std::mt19937                       random_engine(7);
+    std::uniform_int_distribution<int> spin_distribution(0, 1);
+    double                             max_energy_error = 0.0;
+    double                             max_delta_error  = 0.0;
+    for (int index_configuration = 0; index_configuration < 100; index_configuration++) {
+        std::vector<double> spins(lattice.get_number_spins());
+        for (double& spin : spins) {
+            spin = spin_distribution(random_engine) == 1 ? 1.0 : -1.0;
+        }
+        auto bond_energy = [&]() {
+            double energy = 0.0;
+            for (const auto& bond : bonds) {
+                energy -= bond.coupling * spins[bond.first] * spins[bond.second];
+            }
+            return energy;
+        };
+        lattice.set_spins(spins);
+        const double energy = bond_energy();
+        max_energy_error    = std::max(max_energy_error, std::abs(0.5 * lattice.compute_total_energy() - energy));
+
+        const std::size_t site = index_configuration % spins.size();
+        const double      delta = lattice.compute_flip_delta_energy(site);
+        spins[site] *= -1.0;
+        max_delta_error = std::max(max_delta_error, std::abs(delta - (bond_energy() - energy)));
+    }
+    report.check_close(name + " total energy matches the bond Hamiltonian", max_energy_error, 0.0, 1.0e-9);
+    report.check_close(name + " flip energy matches the bond Hamiltonian", max_delta_error, 0.0, 1.0e-9);
+}
+
+template <typename Lattice>
+void check_engine(test_report&                              report,
+                  throughput_log&                           throughput,
+                  const std::string&                        name,
+                  Lattice&                                  lattice,
+                  const std::function<void(Lattice&)>&      sweep,
+                  const thermodynamics&                     exact) {
+    const sampled_run run = sample<Lattice>(lattice, sweep, nb_thermalization, nb_samples);
+    report.check_close(name + " <e>", run.energy.mean(), exact.energy, nb_sigmas * run.energy.standard_error() + 1.0e-4);
+    report.check_close(name + " <|m|>",
+                       run.abs_magnetization.mean(),
+                       exact.abs_magnetization,
+                       nb_sigmas * run.abs_magnetization.standard_error() + 1.0e-4);
+    report.check_close(name + " <m^2>",
+                       run.square_magnetization.mean(),
+                       exact.square_magnetization,
+                       nb_sigmas * run.square_magnetization.standard_error() + 1.0e-4);
+    throughput.record(report, name, lattice.get_shape(), run);
+}
+
+template <typename Lattice>
+std::vector<std::pair<std::string, std::function<void(Lattice&)>>> engines() {
+    auto with_order = [](sweep_order order) {
+        return [order](Lattice& lattice) {
+            lattice.set_sweep_order(order);
+            lattice.metropolis_step();
+        };
+    };
+    return {{"random", with_order(sweep_order::random)},
+            {"sequential", with_order(sweep_order::sequential)},
+            {"strided", with_order(sweep_order::strided)},
+            {"parallel", [](Lattice& lattice) { lattice.metropolis_step_parallel(2); }}};
+}
+
+void check_wang_landau(test_report& report, const ising_base& prototype, const exact_enumeration& exact, double temperature) {
+    wang_landau_parameters parameters;
+    parameters.nb_windows = 2;
+    wang_landau sampler(prototype, parameters);
+    sampler.set_seed(26);
+    sampler.run();
+
+    const auto ln_g_exact = exact.ln_density_of_states();
+    const auto& ln_g      = sampler.get_ln_density_of_states();
+    report.check("wang-landau visits every energy level",
+                 ln_g.size() == ln_g_exact.size(),
+                 std::to_string(ln_g.size()) + " vs " + std::to_string(ln_g_exact.size()) + " levels");
+    double max_error = 0.0;
+    for (const auto& [key, value] : ln_g_exact) {
+        max_error = std::max(max_error, std::abs(ln_g.get(exact.energy(key)) - value));
+    }
+    report.check_close("wang-landau max ln g(E) error", max_error, 0.0, 0.25);
+
+    const thermodynamics reference = exact.compute(temperature);
+    const ising_result   result    = sampler.compute_thermodynamics(temperature);
+    report.check_close("wang-landau <e>", result.energy, reference.energy, 0.02 * std::abs(reference.energy));
+    report.check_close("wang-landau <|m|>", result.magnetization, reference.abs_magnetization, 0.02 * reference.abs_magnetization);
+    report.check_close("wang-landau c", result.specific_heat, reference.specific_heat, 0.1 * reference.specific_heat);
+}
+
+}  // namespace
+
+int main() {
+    test_report    report;
+    throughput_log throughput("exact_enumeration");
+
+    // 4x4 anisotropic square lattice, close to its specific heat maximum.
+    {
+        const double             temperature = 2.5;
+        const auto               bonds       = bonds_2d(4, 4, 1.0, 0.6);
+        const exact_enumeration  exact(16, bonds);
+        const thermodynamics     reference = exact.compute(temperature);
+        ising_2d                 lattice(4, 4, temperature);
+        lattice.set_x_anisotropic_factor(1.0);
+        lattice.set_y_anisotropic_factor(0.6);
+        check_hamiltonian(report, "2d 4x4", lattice, bonds);
+        for (const auto& [name, sweep] : engines<ising_2d>()) {
+            lattice.set_seed(2022);
+            lattice.reset_spins();
+            check_engine<ising_2d>(report, throughput, "2d " + name, lattice, sweep, reference);
+        }
+        lattice.reset_spins();
+        check_wang_landau(report, lattice, exact, temperature);
+    }
+
+    // 3x3x2 lattice: the two z neighbors of a site coincide, which doubles the z bonds.
+    {
+        const double            temperature = 5.0;
+        const auto              bonds       = bonds_3d(3, 3, 2);
+        const exact_enumeration exact(18, bonds);
+        const thermodynamics    reference = exact.compute(temperature);
+        ising_3d                lattice(3, 3, 2, temperature);
+        check_hamiltonian(report, "3d 3x3x2", lattice, bonds);
+        for (const auto& [name, sweep] : engines<ising_3d>()) {
+            lattice.set_seed(2022);
+            lattice.reset_spins();
+            check_engine<ising_3d>(report, throughput, "3d " + name, lattice, sweep, reference);
+        }
+    }
+    return report.exit_code();
+}
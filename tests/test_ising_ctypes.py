@@ -0,0 +1,66 @@
+"""Checks of the ctypes bindings (python/ising_ctypes.py) against the shared library.
+
+Run by CTest with ISING_LIBRARY pointing to the freshly built libising.so; exits with 77 (skipped) without numpy.
+"""
+
+import gc
+import os
+import sys
+import weakref
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "python"))
+
+try:
+    import numpy as np
+    from ising_ctypes import IsingLattice
+except ImportError as error:
+    print(f"Skipped: {error}")
+    sys.exit(77)
+
+failures = 0
+
+
+def check(name, condition, details=""):
+    global failures
+    print(f"[{' OK ' if condition else 'FAIL'}] {name}" + (f" : {details}" if details else ""))
+    failures += not condition
+
+
+# The spin view keeps the lattice alive, even when the lattice object itself is dropped.
+lattice = IsingLattice(24, 16, temperature=2.0)
+lattice.set_seed(27)
+lattice.initialize_random(0.5)
+owner = weakref.ref(lattice)
+spins = lattice.spins
+expected = spins.copy()
+del lattice
+gc.collect()
+check("view keeps the lattice alive", owner() is not None)
+check("view still reads the spins", np.array_equal(spins, expected))
+owner().sweeps(5)
+check("view follows the sweeps", not np.array_equal(spins, expected) and np.all(np.abs(spins) == 1.0))
+del spins
+gc.collect()
+check("lattice released with its last view", owner() is None)
+
+temporary_view = IsingLattice(8, 4, 3, temperature=4.0).spins
+gc.collect()
+check("view of a temporary lattice", temporary_view.shape == (3, 4, 8) and np.all(temporary_view == 1.0))
+del temporary_view
+
+# Same observables conventions in 2D and 3D: totals over the N spins.
+for lattice in [IsingLattice(10, 6, temperature=2.0), IsingLattice(5, 4, 3, temperature=4.0)]:
+    lattice.set_seed(27)
+    lattice.initialize_random(0.7)
+    spins = lattice.spins
+    nb_spins = spins.size
+    observables = lattice.observables()
+    name = f"{len(spins.shape)}d"
+    check(f"{name} magnetization is the sum of the spins", observables["magnetization"] == spins.sum(),
+          f"{observables['magnetization']} vs {spins.sum()}")
+    check(f"{name} susceptibility is M^2 / N", abs(observables["susceptibility"] - spins.sum() ** 2 / nb_spins) < 1e-9)
+    check(f"{name} specific heat is E^2 / N", abs(observables["specific_heat"] - observables["energy"] ** 2 / nb_spins) < 1e-9)
+    lattice.reset_spins()
+    check(f"{name} reset spins magnetization is N", lattice.observables()["magnetization"] == nb_spins)
+
+sys.exit(1 if failures else 0)
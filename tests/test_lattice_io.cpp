@@ -0,0 +1,66 @@
+/**
+ * @file test_lattice_io.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Regression checks of the observables and of the configuration export.
+ * @version 0.1
+ * @date 2022-09-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+int main() {
+    test_report report;
+
+    // ising_base::compute_total_magnetization is the mean spin (ising_3d does not override it).
+    ising_3d            lattice(3, 4, 5);
+    std::vector<double> spins(lattice.get_number_spins(), 1.0);
+    for (std::size_t index = 0; index < spins.size(); index += 3) {
+        spins[index] = -1.0;
+    }
+    lattice.set_spins(spins);
+    report.check_close("3d mean magnetization", lattice.compute_total_magnetization(), (60.0 - 2.0 * 20.0) / 60.0, 1.0e-12);
+
+    // Every site of a non-cubic lattice is exported exactly once, with its own spin.
+    const std::string filename = "test_lattice_io_3d.csv";
+    lattice.export_to_file(filename);
+    std::ifstream                               file(filename);
+    std::string                                 line;
+    std::set<std::tuple<double, double, double>> positions;
+    std::size_t                                 nb_lines      = 0;
+    std::size_t                                 nb_mismatches = 0;
+    std::getline(file, line);
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        double             x, y, z, spin;
+        char               separator;
+        stream >> x >> separator >> y >> separator >> z >> separator >> spin;
+        positions.insert({x, y, z});
+        const auto index_x = static_cast<std::size_t>(std::lround(x * 2.0));
+        const auto index_y = static_cast<std::size_t>(std::lround(y * 3.0));
+        const auto index_z = static_cast<std::size_t>(std::lround(z * 4.0));
+        nb_mismatches += lattice.get_spin(index_x, index_y, index_z) != spin ? 1 : 0;
+        nb_lines++;
+    }
+    file.close();
+    std::filesystem::remove(filename);
+    report.check("3d export writes one line per site", nb_lines == 60, std::to_string(nb_lines) + " lines");
+    report.check("3d export covers every site", positions.size() == 60, std::to_string(positions.size()) + " sites");
+    report.check("3d export spins match the lattice", nb_mismatches == 0, std::to_string(nb_mismatches) + " mismatches");
+
+    return report.exit_code();
+}
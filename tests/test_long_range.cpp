@@ -0,0 +1,149 @@
+/**
+ * @file test_long_range.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check the FFT long-range field against direct sums and exact enumeration.
+ * @version 0.1
+ * @date 2022-10-03
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+/**
+ * @brief Direct evaluation of the kernel between two sites (minimum image), independent of long_range_field.
+ */
+double direct_kernel(const std::array<std::size_t, 3>& shape, const long_range_parameters& parameters, std::size_t i, std::size_t j) {
+    if (i == j) {
+        return 0.0;
+    }
+    std::array<double, 3> delta;
+    std::size_t           stride = 1;
+    for (std::size_t axis = 0; axis < 3; axis++) {
+        const long long a = static_cast<long long>((i / stride) % shape[axis]);
+        const long long b = static_cast<long long>((j / stride) % shape[axis]);
+        const long long d = std::llabs(a - b);
+        delta[axis]       = static_cast<double>(std::min<long long>(d, static_cast<long long>(shape[axis]) - d));
+        stride *= shape[axis];
+    }
+    const double r = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+    if (parameters.kernel == long_range_kernel::power_law) {
+        return parameters.coupling / std::pow(r, parameters.exponent);
+    }
+    return -parameters.coupling * (1.0 - 3.0 * delta[2] * delta[2] / (r * r)) / (r * r * r);
+}
+
+/**
+ * @brief Flip random spins (with a short pending list, so that the field is refreshed along the way) and compare every
+ * flip energy to the direct O(N^2) evaluation of the long-range part plus the nearest-neighbor part.
+ */
+void check_flip_energies(test_report& report, const std::string& name, ising_base& lattice, const long_range_parameters& parameters) {
+    const std::size_t nb_spins = lattice.get_number_spins();
+    const auto        shape    = lattice.get_shape();
+    lattice.set_long_range_interaction(parameters);
+    lattice.initialize_random(0.5);
+
+    std::mt19937                               random_engine(12);
+    std::uniform_int_distribution<std::size_t> site_distribution(0, nb_spins - 1);
+    double                                     max_error = 0.0;
+    for (int index_flip = 0; index_flip < 40; index_flip++) {
+        lattice.flip_spin_at(site_distribution(random_engine));
+        const std::size_t site = site_distribution(random_engine);
+        double            field = 0.0;
+        for (std::size_t j = 0; j < nb_spins; j++) {
+            field += direct_kernel(shape, parameters, site, j) * lattice.get_spin_at(j);
+        }
+        // The nearest-neighbor part is obtained from the same lattice with the long-range mode switched off.
+        auto nearest_neighbor = lattice.clone();
+        nearest_neighbor->disable_long_range_interaction();
+        const double expected = nearest_neighbor->compute_flip_delta_energy(site) + 2.0 * lattice.get_spin_at(site) * field;
+        max_error             = std::max(max_error, std::abs(lattice.compute_flip_delta_energy(site) - expected));
+    }
+    report.check_close(name + " flip energy matches the direct sum", max_error, 0.0, 1.0e-9);
+}
+
+}  // namespace
+
+int main() {
+    test_report    report;
+    throughput_log throughput("long_range");
+
+    // Field and flip energies, including non power-of-two sizes (Bluestein transforms) and the 3D dipolar kernel.
+    {
+        long_range_parameters parameters{long_range_kernel::power_law, 0.7, 2.5, 3};
+        ising_2d              lattice(6, 5, 2.0);
+        check_flip_energies(report, "2d power law", lattice, parameters);
+    }
+    {
+        long_range_parameters parameters{long_range_kernel::dipolar, 0.4, 3.0, 3};
+        ising_3d              lattice(4, 3, 5, 4.0);
+        check_flip_energies(report, "3d dipolar", lattice, parameters);
+    }
+
+    // Metropolis against the exact enumeration of a 4x4 lattice with nearest-neighbor and power-law couplings.
+    {
+        const double                         temperature = 3.0;
+        const long_range_parameters          parameters{long_range_kernel::power_law, 0.3, 2.0, 0};
+        const std::array<std::size_t, 3>     shape = {4, 4, 1};
+        std::vector<exact_enumeration::bond> bonds;
+        for (std::size_t i = 0; i < 16; i++) {
+            const std::size_t x = i % 4;
+            const std::size_t y = i / 4;
+            bonds.push_back({i, (x + 1) % 4 + y * 4, 1.0});
+            bonds.push_back({i, x + ((y + 1) % 4) * 4, 1.0});
+            for (std::size_t j = i + 1; j < 16; j++) {
+                bonds.push_back({i, j, direct_kernel(shape, parameters, i, j)});
+            }
+        }
+        const exact_enumeration exact(16, bonds);
+        const thermodynamics    reference = exact.compute(temperature);
+        for (sweep_order order : {sweep_order::random, sweep_order::sequential}) {
+            ising_2d lattice(4, 4, temperature);
+            lattice.set_seed(34);
+            lattice.set_sweep_order(order);
+            lattice.set_long_range_interaction(parameters);
+            const sampled_run run =
+                sample<ising_2d>(lattice, [](ising_2d& current) { current.metropolis_step(); }, 2000, 64000);
+            const std::string name = order == sweep_order::random ? "random" : "sequential";
+            report.check_close("2d power law " + name + " <e>", run.energy.mean(), reference.energy, 4.0 * run.energy.standard_error() + 1.0e-4);
+            report.check_close("2d power law " + name + " <|m|>",
+                               run.abs_magnetization.mean(),
+                               reference.abs_magnetization,
+                               4.0 * run.abs_magnetization.standard_error() + 1.0e-4);
+        }
+    }
+
+    // Large lattice: throughput of the FFT + pending flips scheme, the parallel sweep is refused.
+    {
+        ising_2d lattice(64, 64, 2.5);
+        lattice.set_seed(34);
+        lattice.set_sweep_order(sweep_order::sequential);
+        lattice.set_long_range_interaction({long_range_kernel::dipolar, 0.1, 3.0, 0});
+        const sampled_run run = sample<ising_2d>(lattice, [](ising_2d& current) { current.metropolis_step(); }, 20, 100);
+        throughput.record(report, "dipolar sequential", lattice.get_shape(), run);
+
+        bool refused = false;
+        try {
+            lattice.metropolis_step_parallel(2);
+        } catch (const std::logic_error&) {
+            refused = true;
+        }
+        report.check("parallel sweep refused in long-range mode", refused);
+    }
+    return report.exit_code();
+}
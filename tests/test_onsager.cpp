@@ -0,0 +1,107 @@
+/**
+ * @file test_onsager.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check the update engines of the square lattice against Onsager's exact energy, magnetization and T_c.
+ * @version 0.1
+ * @date 2022-09-26
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+constexpr std::size_t lattice_size      = 32;
+constexpr std::size_t nb_thermalization = 1000;
+constexpr std::size_t nb_samples        = 8000;
+constexpr double      nb_sigmas         = 4.0;
+
+// Allowance for the finite-size corrections of a 32x32 lattice away from T_c.
+constexpr double finite_size_tolerance = 5.0e-3;
+
+std::vector<std::pair<std::string, std::function<void(ising_2d&)>>> engines() {
+    auto with_order = [](sweep_order order) {
+        return [order](ising_2d& lattice) {
+            lattice.set_sweep_order(order);
+            lattice.metropolis_step();
+        };
+    };
+    return {{"random", with_order(sweep_order::random)},
+            {"sequential", with_order(sweep_order::sequential)},
+            {"strided", with_order(sweep_order::strided)},
+            {"parallel", [](ising_2d& lattice) { lattice.metropolis_step_parallel(2); }}};
+}
+
+double binder_cumulant(const sampled_run& run) {
+    const double square = run.square_magnetization.mean();
+    return 1.0 - run.fourth_magnetization.mean() / (3.0 * square * square);
+}
+
+/**
+ * @brief Binder cumulant of an L x L lattice at a given temperature, sampled with sequential sweeps.
+ */
+double sample_binder_cumulant(std::size_t size, double temperature, std::size_t nb_sweeps) {
+    ising_2d lattice(size, size, temperature);
+    lattice.set_seed(1944);
+    lattice.set_sweep_order(sweep_order::sequential);
+    const sampled_run run = sample<ising_2d>(lattice, [](ising_2d& current) { current.metropolis_step(); }, 1000, nb_sweeps);
+    return binder_cumulant(run);
+}
+
+}  // namespace
+
+int main() {
+    test_report    report;
+    throughput_log throughput("onsager");
+
+    // Ordered phase: energy and spontaneous magnetization.
+    // Disordered phase: energy only, the magnetization of a finite lattice does not vanish.
+    const std::vector<std::pair<double, bool>> temperatures = {{1.8, true}, {3.0, false}};
+    for (const auto& [name, sweep] : engines()) {
+        for (const auto& [temperature, ordered] : temperatures) {
+            ising_2d lattice(lattice_size, lattice_size, temperature);
+            lattice.set_seed(1944);
+            const sampled_run run    = sample<ising_2d>(lattice, sweep, nb_thermalization, nb_samples);
+            const std::string prefix = name + " T=" + std::to_string(temperature).substr(0, 3);
+            report.check_close(prefix + " <e>",
+                               run.energy.mean(),
+                               onsager::energy_per_spin(temperature),
+                               nb_sigmas * run.energy.standard_error() + finite_size_tolerance);
+            if (ordered) {
+                report.check_close(prefix + " <|m|>",
+                                   run.abs_magnetization.mean(),
+                                   onsager::magnetization_per_spin(temperature),
+                                   nb_sigmas * run.abs_magnetization.standard_error() + finite_size_tolerance);
+                throughput.record(report, name, lattice.get_shape(), run);
+            }
+        }
+    }
+
+    // T_c bracket: the Binder cumulants of two lattice sizes cross at T_c, the larger lattice being closer to 2/3
+    // below T_c and closer to 0 above.
+    const double lower_temperature = 0.95 * onsager::critical_temperature;
+    const double upper_temperature = 1.05 * onsager::critical_temperature;
+    const double small_lower       = sample_binder_cumulant(8, lower_temperature, 100000);
+    const double large_lower       = sample_binder_cumulant(16, lower_temperature, 100000);
+    const double small_upper       = sample_binder_cumulant(8, upper_temperature, 100000);
+    const double large_upper       = sample_binder_cumulant(16, upper_temperature, 100000);
+    report.check("Binder cumulant U_16 > U_8 below T_c",
+                 large_lower > small_lower,
+                 std::to_string(large_lower) + " vs " + std::to_string(small_lower));
+    report.check("Binder cumulant U_16 < U_8 above T_c",
+                 large_upper < small_upper,
+                 std::to_string(large_upper) + " vs " + std::to_string(small_upper));
+    return report.exit_code();
+}
@@ -0,0 +1,99 @@
+/**
+ * @file test_simulate.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Checks of the streaming simulation API: laziness, decimation, stop conditions and cancellation.
+ * @version 0.1
+ * @date 2022-09-28
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <numeric>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+int main() {
+    test_report report;
+
+    // The generator drives exactly the same sweeps as calling metropolis_step() directly.
+    {
+        ising_2d reference(16, 12, 2.2);
+        ising_2d streamed(16, 12, 2.2);
+        reference.set_seed(33);
+        streamed.set_seed(33);
+        for (int step = 0; step < 50; step++) {
+            reference.metropolis_step();
+        }
+        std::size_t nb_records    = 0;
+        bool        records_match = true;
+        for (const sweep_record& record : streamed.simulate(50)) {
+            records_match = records_match && record.sweep == nb_records && record.iteration == nb_records + 1 &&
+                            record.energy == streamed.compute_total_energy() &&
+                            record.magnetization == streamed.compute_total_magnetization();
+            nb_records++;
+        }
+        report.check("one record per sweep", nb_records == 50, std::to_string(nb_records) + " records");
+        report.check("records match the lattice observables", records_match);
+        report.check("same sweeps as metropolis_step()", reference.get_spins() == streamed.get_spins());
+    }
+
+    // Laziness: nothing runs before the first record is requested, and leaving the loop stops the simulation.
+    {
+        ising_3d lattice(6, 6, 6, 4.0);
+        auto     records = lattice.simulate(100);
+        report.check("no sweep before iteration", lattice.get_number_iterations() == 0);
+        for (const sweep_record& record : records) {
+            if (record.sweep == 9) {
+                break;
+            }
+        }
+        report.check("break stops the simulation", lattice.get_number_iterations() == 10,
+                     std::to_string(lattice.get_number_iterations()) + " sweeps");
+    }
+
+    // Decimation, callbacks and cancellation.
+    {
+        ising_2d           lattice(8, 8, 2.0);
+        simulation_options options;
+        options.record_stride = 7;
+        std::size_t nb_progress = 0;
+        options.on_progress     = [&nb_progress](const sweep_record&) { nb_progress++; };
+        std::size_t nb_records  = 0;
+        for ([[maybe_unused]] const sweep_record& record : lattice.simulate(100, options)) {
+            nb_records++;
+        }
+        report.check("record_stride decimates the records", nb_records == 14 && nb_progress == 14,
+                     std::to_string(nb_records) + " records, " + std::to_string(nb_progress) + " progress calls");
+        report.check("decimated simulation runs every sweep", lattice.get_number_iterations() == 100);
+
+        lattice.reset_spins();
+        simulation_options stop_options;
+        stop_options.stop_condition = [](const sweep_record& record) { return record.iteration == 25; };
+        std::size_t last_sweep      = 0;
+        for (const sweep_record& record : lattice.simulate(100, stop_options)) {
+            last_sweep = record.sweep;
+        }
+        report.check("stop condition ends after its record", last_sweep == 24 && lattice.get_number_iterations() == 25);
+
+        lattice.reset_spins();
+        std::stop_source   stop_source;
+        simulation_options cancel_options;
+        cancel_options.stop_token = stop_source.get_token();
+        for (const sweep_record& record : lattice.simulate(100, cancel_options)) {
+            if (record.sweep == 4) {
+                stop_source.request_stop();
+            }
+        }
+        report.check("stop token cancels the simulation", lattice.get_number_iterations() == 5,
+                     std::to_string(lattice.get_number_iterations()) + " sweeps");
+    }
+    return report.exit_code();
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_spin_storage.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Checks of the file-backed spin storage: same trajectories as in memory, clones, and no file left behind.
+ * @version 0.1
+ * @date 2022-10-07
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+/**
+ * @brief Number of spin files currently mapped by the process. They are unlinked right after their creation, so they only
+ * show up in /proc/self/maps, as deleted files.
+ */
+std::size_t count_spin_mappings() {
+    std::ifstream         maps("/proc/self/maps");
+    std::set<std::string> files;
+    std::string           line;
+    while (std::getline(maps, line)) {
+        if (line.find("/ising_spins_") != std::string::npos && line.find("(deleted)") != std::string::npos) {
+            files.insert(line.substr(line.find('/')));
+        }
+    }
+    return files.size();
+}
+
+}  // namespace
+
+int main() {
+    test_report    report;
+    throughput_log throughput("spin_storage");
+
+    const std::filesystem::path directory = std::filesystem::current_path() / "spin_storage";
+    std::filesystem::create_directories(directory);
+
+    // Every sweep gives bit for bit the same trajectory in a file as in memory, the slab hooks releasing and reading
+    // back the planes along the way. An odd number of planes exercises the wrap-around and the last parallel plane.
+    const std::vector<std::pair<std::string, std::function<void(ising_3d&)>>> engines = {
+        {"sequential", [](ising_3d& lattice) { lattice.set_sweep_order(sweep_order::sequential); }},
+        {"strided", [](ising_3d& lattice) { lattice.set_sweep_order(sweep_order::strided); }},
+        {"parallel", [](ising_3d& lattice) { lattice.set_number_threads(2); }},
+    };
+    for (const auto& [name, configure] : engines) {
+        ising_3d in_memory(24, 20, 9, 4.5);
+        ising_3d file_backed(24, 20, 9, 4.5, directory.string());
+        report.check(name + " storage flags", !in_memory.is_file_backed() && file_backed.is_file_backed());
+        for (ising_3d* lattice : {&in_memory, &file_backed}) {
+            lattice->set_seed(36);
+            lattice->initialize_random(0.5);
+            configure(*lattice);
+            for (int sweep = 0; sweep < 30; sweep++) {
+                lattice->metropolis_step();
+            }
+        }
+        report.check(name + " file-backed trajectory", in_memory.get_spins() == file_backed.get_spins());
+        report.check(name + " file-backed energy", in_memory.compute_total_energy() == file_backed.compute_total_energy());
+    }
+
+    // The random order has no locality: file-backed lattices sweep sequentially and refuse it.
+    {
+        ising_3d lattice(8, 8, 8, 4.0, directory.string());
+        report.check("file-backed default order is sequential", lattice.get_sweep_order() == sweep_order::sequential);
+        bool refused = false;
+        try {
+            lattice.set_sweep_order(sweep_order::random);
+        } catch (const std::logic_error&) {
+            refused = true;
+        }
+        report.check("file-backed lattice refuses the random order", refused && lattice.get_sweep_order() == sweep_order::sequential);
+
+        ising_3d moved(8, 8, 8, 4.0);
+        moved.set_spin_storage(directory.string());
+        report.check("moved lattice leaves the random order", moved.get_sweep_order() == sweep_order::sequential);
+    }
+
+    // Moving the spins between memory and a file keeps them, and a clone of a file-backed lattice has its own file.
+    {
+        ising_3d lattice(16, 16, 8, 4.0);
+        lattice.set_seed(7);
+        lattice.initialize_random(0.5);
+        const std::vector<double> spins(lattice.get_spins().begin(), lattice.get_spins().end());
+        lattice.set_spin_storage(directory.string());
+        report.check("moved to a file", lattice.is_file_backed() && std::equal(spins.begin(), spins.end(), lattice.get_spins().begin()));
+
+        const std::size_t nb_mappings = count_spin_mappings();
+        {
+            auto copy = lattice.clone();
+            copy->flip_spin_at(0);
+            report.check("clone is file-backed", copy->is_file_backed());
+            report.check("clone is independent", copy->get_spin_at(0) == -lattice.get_spin_at(0));
+            report.check("clone has its own file", count_spin_mappings() == nb_mappings + 1,
+                         std::to_string(count_spin_mappings()) + " mapped spin files");
+        }
+        report.check("clone file released", count_spin_mappings() == nb_mappings);
+
+        lattice.set_spin_storage("");
+        report.check("moved back to memory", !lattice.is_file_backed() && std::equal(spins.begin(), spins.end(), lattice.get_spins().begin()));
+        report.check("spin files released", count_spin_mappings() == 0, std::to_string(count_spin_mappings()) + " mapped spin files");
+    }
+
+    // Throughput of the streamed sweeps, to compare with the in-memory records of the other tests.
+    for (sweep_order order : {sweep_order::sequential, sweep_order::strided}) {
+        ising_3d lattice(64, 64, 64, 4.5, directory.string());
+        lattice.set_seed(36);
+        lattice.set_sweep_order(order);
+        const sampled_run run = sample<ising_3d>(lattice, [](ising_3d& current) { current.metropolis_step(); }, 2, 5);
+        throughput.record(report, order == sweep_order::sequential ? "file sequential" : "file strided", lattice.get_shape(), run);
+    }
+    std::filesystem::remove_all(directory);
+    return report.exit_code();
+}
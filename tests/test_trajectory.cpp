@@ -0,0 +1,137 @@
+/**
+ * @file test_trajectory.cpp
+ * @author remzerrr (remi.helleboid@gmail.com)
+ * @brief Check that recorded trajectories replay every sweep exactly, and that they stay small at low temperature.
+ * @version 0.1
+ * @date 2022-10-12
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ising_2d.hpp"
+#include "ising_3d.hpp"
+#include "physics_checks.hpp"
+#include "trajectory.hpp"
+
+using namespace physics_checks;
+
+namespace {
+
+using configuration = std::vector<double>;
+
+configuration snapshot(const ising_base& lattice) { return configuration(lattice.get_spins().begin(), lattice.get_spins().end()); }
+
+/**
+ * @brief Record nb_sweeps sweeps of the lattice, keeping the expected configuration of each sweep.
+ */
+std::vector<configuration> record(ising_base& lattice, const std::string& filename, std::size_t keyframe_interval, std::size_t nb_sweeps) {
+    std::vector<configuration> expected = {snapshot(lattice)};
+    lattice.start_trajectory_recording(filename, keyframe_interval);
+    for (std::size_t sweep = 0; sweep < nb_sweeps; sweep++) {
+        lattice.metropolis_step();
+        expected.push_back(snapshot(lattice));
+    }
+    lattice.stop_trajectory_recording();
+    return expected;
+}
+
+/**
+ * @brief Replay the file in order, then seek the sweeps in random order.
+ */
+void check_replay(test_report& report, const std::string& name, const std::string& filename, const std::vector<configuration>& expected) {
+    trajectory_reader reader(filename);
+    report.check(name + " number of sweeps", reader.get_number_sweeps() == expected.size(),
+                 std::to_string(reader.get_number_sweeps()) + " sweeps");
+    bool in_order = true;
+    while (reader.next()) {
+        in_order = in_order && reader.get_sweep() < expected.size() && reader.get_spins() == expected[reader.get_sweep()];
+    }
+    report.check(name + " sequential replay", in_order);
+
+    std::mt19937                               random_engine(38);
+    std::uniform_int_distribution<std::size_t> sweep_distribution(0, expected.size() - 1);
+    bool                                       random_access = true;
+    for (int index_seek = 0; index_seek < 60; index_seek++) {
+        const std::size_t sweep = sweep_distribution(random_engine);
+        random_access           = random_access && reader.seek(sweep) == expected[sweep];
+    }
+    report.check(name + " random seeks", random_access);
+}
+
+}  // namespace
+
+int main() {
+    test_report report;
+
+    // Random order: sites flipped twice in a sweep cancel out.
+    {
+        ising_2d lattice(32, 24, 2.4);
+        lattice.set_seed(38);
+        lattice.initialize_random(0.5);
+        const auto expected = record(lattice, "test_trajectory_2d.trajectory", 7, 40);
+        check_replay(report, "2d random", "test_trajectory_2d.trajectory", expected);
+    }
+
+    // Parallel sweep (one flip buffer per thread) on an odd number of planes.
+    {
+        ising_3d lattice(8, 6, 7, 4.5);
+        lattice.set_seed(38);
+        lattice.initialize_random(0.5);
+        lattice.set_number_threads(3);
+        const auto expected = record(lattice, "test_trajectory_3d.trajectory", 5, 23);
+        check_replay(report, "3d parallel", "test_trajectory_3d.trajectory", expected);
+    }
+
+    // Spins overwritten during the recording, clones and direct flips.
+    {
+        ising_2d lattice(16, 16, 2.0);
+        lattice.set_seed(38);
+        lattice.set_sweep_order(sweep_order::sequential);
+        std::vector<configuration> expected = {snapshot(lattice)};
+        lattice.start_trajectory_recording("test_trajectory_edits.trajectory", 100);
+        for (std::size_t sweep = 0; sweep < 12; sweep++) {
+            if (sweep == 4) {
+                lattice.initialize_random(0.3);
+            }
+            if (sweep == 8) {
+                auto copy = lattice.clone();
+                report.check("clone is not recorded", !copy->is_recording_trajectory());
+                copy->metropolis_step();
+                lattice.set_spin(3, 5, -lattice.get_spin(3, 5));
+            }
+            lattice.metropolis_step();
+            expected.push_back(snapshot(lattice));
+        }
+        lattice.stop_trajectory_recording();
+        check_replay(report, "overwritten spins", "test_trajectory_edits.trajectory", expected);
+    }
+
+    // Low temperature: the records scale with the number of flips, not with the lattice size.
+    {
+        ising_2d lattice(128, 128, 1.2);
+        lattice.set_seed(38);
+        lattice.set_sweep_order(sweep_order::sequential);
+        for (int sweep = 0; sweep < 20; sweep++) {
+            lattice.metropolis_step();
+        }
+        record(lattice, "test_trajectory_cold.trajectory", 1000, 100);
+        const double keyframe_bytes = 128.0 * 128.0 / 8.0;
+        const double delta_bytes    = (static_cast<double>(std::filesystem::file_size("test_trajectory_cold.trajectory")) - keyframe_bytes) / 100.0;
+        report.check("low temperature deltas are small", delta_bytes < 0.1 * keyframe_bytes,
+                     std::to_string(delta_bytes) + " bytes per sweep, keyframe " + std::to_string(keyframe_bytes));
+
+        // An interrupted recording loses its last record only.
+        std::filesystem::copy_file("test_trajectory_cold.trajectory", "test_trajectory_truncated.trajectory",
+                                   std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::resize_file("test_trajectory_truncated.trajectory", std::filesystem::file_size("test_trajectory_cold.trajectory") - 1);
+        trajectory_reader truncated("test_trajectory_truncated.trajectory");
+        report.check("truncated file", truncated.get_number_sweeps() == 100, std::to_string(truncated.get_number_sweeps()) + " sweeps");
+    }
+    return report.exit_code();
+}